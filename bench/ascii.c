@@ -0,0 +1,63 @@
+// Measures the per-cell cost of classifying text as ASCII, comparing the
+// byte-at-a-time loop the loop thread used to run with text_is_ascii.
+//
+// Only cells of at least EXTERNAL_TEXT_MIN_LENGTH (1024) bytes are scanned,
+// since the tag only decides whether such a cell becomes an external string
+// or is copied. Shorter cells are always built with String::New, which
+// decodes UTF-8, so they are not measured here. bench/decode.js times the
+// string building itself.
+//
+//   cc -O2 -std=gnu99 -Isrc bench/ascii.c src/ascii.c -o ascii_bench
+//   ./ascii_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ascii.h"
+
+#define TOTAL_BYTES (64 * 1024 * 1024)
+
+static int bytewise_is_ascii(const char *text, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		if ((unsigned char)text[i] >= 0x80) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double measure(int (*is_ascii)(const char *, size_t), const char *cells, size_t cell_length, size_t cell_count) {
+	volatile int ascii_cells = 0;
+	const double start = now();
+	for (size_t i = 0; i < cell_count; i++) {
+		ascii_cells += is_ascii(cells + i * cell_length, cell_length);
+	}
+	return (now() - start) / cell_count;
+}
+
+int main(void) {
+	static const size_t cell_lengths[] = { 1024, 4096, 16384, 65536 };
+	char *cells = malloc(TOTAL_BYTES);
+	for (size_t i = 0; i < TOTAL_BYTES; i++) {
+		cells[i] = 'a' + (char)(i % 26);
+	}
+	
+	printf("%10s %14s %14s %8s\n", "cell bytes", "bytewise ns", "kernel ns", "speedup");
+	for (size_t i = 0; i < sizeof(cell_lengths) / sizeof(cell_lengths[0]); i++) {
+		const size_t cell_length = cell_lengths[i];
+		const size_t cell_count = TOTAL_BYTES / cell_length;
+		const double before = measure(bytewise_is_ascii, cells, cell_length, cell_count);
+		const double after = measure(text_is_ascii, cells, cell_length, cell_count);
+		printf("%10zu %14.1f %14.1f %7.1fx\n", cell_length, before, after, before / after);
+	}
+	
+	free(cells);
+	return 0;
+}
\ No newline at end of file
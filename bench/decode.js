@@ -0,0 +1,87 @@
+// Times all() on rows of one text column, comparing ASCII cells with cells
+// of the same length holding one two-byte character. Cells of at least 1024
+// bytes that are tagged ASCII on the worker become external strings over the
+// result, the others are copied and decoded as UTF-8 with String::New.
+// Shorter cells are never tagged, so both columns should match there.
+//
+//   node bench/decode.js
+
+var sqlite = require('..').lowLevel;
+
+var ROWS = 2000;
+var ROUNDS = 20;
+var CELL_LENGTHS = [16, 256, 1024, 4096, 16384];
+
+function repeat(text, count) {
+	return new Array(count + 1).join(text);
+}
+
+function cellText(length, ascii) {
+	return ascii ? repeat('a', length) : '\u00e9' + repeat('a', length - 2);
+}
+
+// Nanoseconds per cell of the fastest round.
+function measure(stmt, text, callback) {
+	stmt.bind(text, 1);
+	var best = Infinity;
+	var round = 0;
+
+	function next(err, rows) {
+		if (err) {
+			return callback(err);
+		}
+		if (round > 0) {
+			var elapsed = process.hrtime(start);
+			best = Math.min(best, (elapsed[0] * 1e9 + elapsed[1]) / rows.length);
+		}
+		if (round++ === ROUNDS) {
+			return callback(null, best);
+		}
+		start = process.hrtime();
+		stmt.all(next);
+	}
+
+	var start = process.hrtime();
+	stmt.all(next);
+}
+
+function pad(value, width) {
+	value = String(value);
+	return repeat(' ', width - value.length) + value;
+}
+
+sqlite.open(':memory:', function(err, db) {
+	if (err) {
+		throw err;
+	}
+
+	var sql = 'with recursive c(x) as (select 1 union all select x + 1 from c where x < ' + ROWS + ') select ? as text from c';
+	db.prepare(sql, function(err, stmt) {
+		if (err) {
+			throw err;
+		}
+
+		console.log(pad('cell bytes', 10) + pad('ascii ns', 14) + pad('utf-8 ns', 14));
+		var i = 0;
+		(function nextLength() {
+			if (i === CELL_LENGTHS.length) {
+				stmt.finalize();
+				return db.close(function() {});
+			}
+
+			var length = CELL_LENGTHS[i++];
+			measure(stmt, cellText(length, true), function(err, ascii) {
+				if (err) {
+					throw err;
+				}
+				measure(stmt, cellText(length, false), function(err, utf8) {
+					if (err) {
+						throw err;
+					}
+					console.log(pad(length, 10) + pad(ascii.toFixed(1), 14) + pad(utf8.toFixed(1), 14));
+					nextLength();
+				});
+			});
+		})();
+	});
+});
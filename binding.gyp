@@ -4,12 +4,20 @@
     		"target_name": "sqlite",
 			"sources": [
 				"src/addon.cc",
+				"src/arena.c",
+				"src/ascii.c",
+				"src/async.c",
 				"src/bindings.c",
+				"src/completion.c",
 				"src/db.c",
 				"src/db_wrapper.cc",
+				"src/pool.c",
+				"src/queue.c",
+				"src/result_wrapper.cc",
 				"src/results.c",
                 "src/statement.c",
                 "src/statement_wrapper.cc",
+				"src/worker.c",
                 "src/sqlite3/sqlite3.c"
 			],
 			"conditions": [
@@ -17,6 +17,8 @@ function errorCodeDescription(errorCode) {
 			return 'Successful result';
 		case errorCodes.SQLITE_ERROR:
 			return 'SQL error or missing database';
+		case errorCodes.SQLITE_INTERRUPT:
+			return 'Operation terminated by sqlite3_interrupt()';
 		case errorCodes.SQLITE_MISUSE:
 			return 'Library used incorrectly';
 		case errorCodes.SQLITE_RANGE:
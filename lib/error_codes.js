@@ -1,6 +1,7 @@
 module.exports = {
 	SQLITE_OK: 0,
 	SQLITE_ERROR: 1,
+	SQLITE_INTERRUPT: 9,
 	SQLITE_MISUSE: 21,
 	SQLITE_RANGE: 25,
 	SQLITE_NOTADB: 26,
@@ -1,26 +1,148 @@
+var Readable = require('stream').Readable;
+var util = require('util');
 var addon = require('../build/Release/sqlite');
 var describeError = require('./describe_error.js');
 var errorCodes = require('./error_codes.js');
+var PackedReader = require('./packed_reader.js');
 var datatypeCodes = require('./datatype_codes.js');
 
+var priorities = {
+	interactive: 0,
+	background: 1
+};
+
+// Maps the `priority` option of an operation onto a native lane, or returns
+// undefined to keep the default one.
+function priorityLane(options) {
+	if (!options || options.priority === undefined) {
+		return undefined;
+	}
+
+	if (!priorities.hasOwnProperty(options.priority)) {
+		throw new Error('Unknown priority: ' + options.priority);
+	}
+
+	return priorities[options.priority];
+}
+
+// Flags of whole-result and batch fetches, see ResultFlags in the addon.
+var RESULT_FLAG_LAZY = 1;
+var RESULT_FLAG_INTERN = 2;
+
+function resultFlags(options) {
+	if (!options || typeof options !== 'object') {
+		return 0;
+	}
+	return (options.lazy === true ? RESULT_FLAG_LAZY : 0) | (options.intern === true ? RESULT_FLAG_INTERN : 0);
+}
+
+function operationTimeout(options) {
+	if (!options || options.timeout === undefined) {
+		return 0;
+	}
+
+	if (typeof options.timeout !== 'number' || options.timeout < 0) {
+		throw new Error('Timeout must be a non-negative number of milliseconds.');
+	}
+
+	return options.timeout;
+}
+
+// Batch limits for stream and fetchPacked.
+var DEFAULT_BATCH_ROWS = 256;
+var DEFAULT_BATCH_BYTES = 1024 * 1024;
+
+// Promises are created with this constructor. It defaults to the global
+// Promise, where the runtime has one, and can be replaced with
+// setPromiseConstructor.
+var PromiseConstructor = typeof Promise === 'function' ? Promise : null;
+
+// The executor below stores the settling functions of the promise being
+// created here, so that no closure is needed for each promise.
+var settlers = {
+	resolve: null,
+	reject: null
+};
+
+function captureSettlers(resolve, reject) {
+	settlers.resolve = resolve;
+	settlers.reject = reject;
+}
+
+function newPromise() {
+	if (PromiseConstructor === null) {
+		throw new Error('No Promise implementation available, use setPromiseConstructor.');
+	}
+	return new PromiseConstructor(captureSettlers);
+}
+
+// A promise for an operation that settles it through a queued entry, or
+// undefined when a callback is given. The settling functions are left in
+// `settlers` until the entry is queued.
+function promiseUnless(callback) {
+	return typeof callback === 'function' ? undefined : newPromise();
+}
+
 function makeError(errorCode) {
 	var error = Error(describeError(errorCode));
 	error.code = errorCode;
 	return error;
 }
 
+// Opens, closes and prepares all complete through onComplete, which lets the
+// addon keep a single callback handle for them. Each pending operation
+// queues four entries: the wrapper the addon reports back, the value it
+// settles with, and either a node-style callback and null or the resolve and
+// reject functions of its promise. Operations on a shared connection can
+// complete out of order, so completions look up their wrapper.
+var pendingCompletions = [];
+
+function queueCompletion(wrapper, value, callback) {
+	if (typeof callback === 'function') {
+		pendingCompletions.push(wrapper, value, callback, null);
+	} else {
+		pendingCompletions.push(wrapper, value, settlers.resolve, settlers.reject);
+	}
+}
+
+function onComplete(errorCode, wrapper) {
+	var i = 0;
+	while (pendingCompletions[i] !== wrapper) {
+		i += 4;
+	}
+
+	var value = pendingCompletions[i + 1];
+	var callback = pendingCompletions[i + 2];
+	var reject = pendingCompletions[i + 3];
+	var length = pendingCompletions.length;
+	for (i += 4; i < length; i++) {
+		pendingCompletions[i - 4] = pendingCompletions[i];
+	}
+	pendingCompletions.length = length - 4;
+
+	if (errorCode === errorCodes.SQLITE_OK) {
+		if (reject !== null) {
+			callback(value);
+		} else {
+			callback(null, value);
+		}
+	} else if (reject !== null) {
+		reject(makeError(errorCode));
+	} else {
+		callback(makeError(errorCode), null);
+	}
+}
+
 function LowLevelDb(dbWrapper) {
 	this.dbWrapper = dbWrapper;
 }
 
+// Returns a promise when no callback is given.
 LowLevelDb.prototype.close = function(callback) {
-	addon.close(this.dbWrapper, function(errorCode) {
-		if (errorCode === errorCodes.SQLITE_OK) {
-			callback(null);
-		} else {
-			callback(makeError(errorCode));
-		}
-	});
+	var promise = promiseUnless(callback);
+	addon.close(this.dbWrapper, onComplete);
+	queueCompletion(this.dbWrapper, undefined, callback);
+	return promise;
 };
 
 LowLevelDb.prototype.errMsg = function() {
@@ -39,21 +161,75 @@ LowLevelDb.prototype.lastInsertRowId = function() {
 	return addon.lastInsertRowId(this.dbWrapper);
 };
 
-LowLevelDb.prototype.prepare = function(sql, callback) {
+// The `priority` option ('interactive' or 'background') applies to the
+// prepare itself and becomes the default for every step of the statement.
+// Returns a promise when no callback is given.
+LowLevelDb.prototype.prepare = function(sql, options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	var statement = new LowLevelStatement(new addon.StatementWrapper());
+	var promise = promiseUnless(callback);
+	addon.prepare(this.dbWrapper, statement.statementWrapper, sql, priorityLane(options), onComplete);
+	queueCompletion(statement.statementWrapper, statement, callback);
+	return promise;
+};
+
+LowLevelDb.prototype.prepareSync = function(sql) {
 	var statementWrapper = new addon.StatementWrapper();
-	addon.prepare(this.dbWrapper, statementWrapper, sql, function(errorCode) {
-		if (errorCode === errorCodes.SQLITE_OK) {
-			var statement = new LowLevelStatement(statementWrapper);
-			callback(null, statement);
-		} else {
-			callback(makeError(errorCode), null);
-		}
-	});
+	var errorCode = addon.prepareSync(this.dbWrapper, statementWrapper, sql);
+	if (errorCode !== errorCodes.SQLITE_OK) {
+		throw makeError(errorCode);
+	}
+	return new LowLevelStatement(statementWrapper);
 };
 
 function LowLevelStatement(statementWrapper) {
 	this.statementWrapper = statementWrapper;
 	this.bindParameterCursor = 1;
+	this.stepCallbacks = [];
+	this.onStep = makeStepHandler(this);
+	this.fillCallback = null;
+	this.fillReject = null;
+	this.onFill = makeFillHandler(this);
+	this.resultCallbacks = [];
+	this.onResult = makeResultHandler(this);
+}
+
+// Every step of a statement completes through the same function, which lets
+// the addon keep a single callback handle for the statement's lifetime.
+// Each pending step queues three entries: either a node-style callback and
+// null, or the resolve and reject functions of its promise, followed by
+// whether it wants the row count.
+function makeStepHandler(statement) {
+	return function onStep(errorCode, rows) {
+		var callback = statement.stepCallbacks.shift();
+		var reject = statement.stepCallbacks.shift();
+		var reportRows = statement.stepCallbacks.shift();
+
+		switch (errorCode) {
+			case errorCodes.SQLITE_OK:
+			case errorCodes.SQLITE_ROW:
+			case errorCodes.SQLITE_DONE:
+				if (reject !== null) {
+					callback(reportRows ? [errorCode, rows] : errorCode);
+				} else if (reportRows) {
+					callback(null, errorCode, rows);
+				} else {
+					callback(null, errorCode);
+				}
+				break;
+			default:
+				if (reject !== null) {
+					reject(makeError(errorCode));
+				} else {
+					callback(makeError(errorCode), null);
+				}
+				break;
+		}
+	};
 }
 
 LowLevelStatement.prototype.bind = function(value, index) {
@@ -77,19 +253,298 @@ LowLevelStatement.prototype.bindAll = function(values) {
 	}
 };
 
-LowLevelStatement.prototype.step = function(callback) {
-	addon.step(this.statementWrapper, function(errorCode) {
-		switch (errorCode) {
-			case errorCodes.SQLITE_OK:
-			case errorCodes.SQLITE_ROW:
-			case errorCodes.SQLITE_DONE:
-				callback(null, errorCode);
-				break;
-			default:
-				callback(makeError(errorCode), null);
-				break;
+// Queues the completion of a step, returning a promise when no callback is
+// given.
+function enqueueStep(statement, callback, reportRows) {
+	var promise;
+	if (typeof callback === 'function') {
+		statement.stepCallbacks.push(callback, null, reportRows);
+	} else {
+		promise = newPromise();
+		statement.stepCallbacks.push(settlers.resolve, settlers.reject, reportRows);
+	}
+	return promise;
+}
+
+// Options:
+//  - priority: 'interactive' or 'background'
+//  - timeout: milliseconds after which the step fails with SQLITE_INTERRUPT.
+//    A step waiting behind other operations of the statement fails as soon
+//    as they are done.
+// Returns a promise when no callback is given.
+LowLevelStatement.prototype.step = function(options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	var lane = priorityLane(options);
+	var timeout = operationTimeout(options);
+	var promise = enqueueStep(this, callback, false);
+	addon.step(this.statementWrapper, lane, timeout, this.onStep);
+	return promise;
+};
+
+// Steps up to `count` times in one round trip. The callback receives the
+// last result code and the number of rows stepped over, a promise resolves
+// to both as an array.
+LowLevelStatement.prototype.stepN = function(count, options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	if (count !== parseInt(count, 10) || count < 1) {
+		throw new Error('Count must be a positive integer.');
+	}
+
+	var lane = priorityLane(options);
+	var timeout = operationTimeout(options);
+	var promise = enqueueStep(this, callback, true);
+	addon.stepN(this.statementWrapper, count, lane, timeout, this.onStep);
+	return promise;
+};
+
+// Like steps, operations run on a worker complete through one function per
+// statement, and in the order they were started. Each pending one queues
+// three entries: either a node-style callback and null, or the resolve and
+// reject functions of its promise, followed by the function making its
+// result.
+function makeResultHandler(statement) {
+	return function onResult(errorCode, results, extra) {
+		var callback = statement.resultCallbacks.shift();
+		var reject = statement.resultCallbacks.shift();
+		var makeResult = statement.resultCallbacks.shift();
+
+		if (errorCode === errorCodes.SQLITE_DONE || errorCode === errorCodes.SQLITE_ROW) {
+			var result = makeResult(results, extra, errorCode === errorCodes.SQLITE_DONE);
+			if (reject !== null) {
+				callback(result);
+			} else {
+				callback(null, result);
+			}
+		} else if (reject !== null) {
+			reject(makeError(errorCode));
+		} else {
+			callback(makeError(errorCode), null);
 		}
-	});
+	};
+}
+
+// Runs the statement on a worker through the given addon function, which
+// reports a status code followed by its results. Batches that stop at their
+// limits report SQLITE_ROW instead of SQLITE_DONE. The extra argument is
+// passed on to the addon after the lane and timeout, ahead of the callback.
+function runOnWorker(statement, run, options, callback, makeResult, extra) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	var promise = promiseUnless(callback);
+	run(statement.statementWrapper, priorityLane(options), operationTimeout(options), extra, statement.onResult);
+	if (promise === undefined) {
+		statement.resultCallbacks.push(callback, null, makeResult);
+	} else {
+		statement.resultCallbacks.push(settlers.resolve, settlers.reject, makeResult);
+	}
+	return promise;
+}
+
+function identity(value) {
+	return value;
+}
+
+// Returns every row as an object keyed by column name. The statement is
+// reset afterwards. Takes the same options as step, and returns a promise
+// when no callback is given. With the lazy option, rows are read-only and
+// each column is only decoded when it is first read. With the intern option,
+// repeated short text values share one string.
+LowLevelStatement.prototype.all = function(options, callback) {
+	return runOnWorker(this, addon.all, options, callback, identity, resultFlags(options));
+};
+
+function getRow(statementWrapper, lane, timeout, params, onRow) {
+	addon.get(statementWrapper, params, lane, timeout, false, onRow);
+}
+
+function pluckValue(statementWrapper, lane, timeout, params, onValue) {
+	addon.get(statementWrapper, params, lane, timeout, true, onValue);
+}
+
+// Binds the optional array of parameters, then steps once, reads the row
+// and resets the statement in a single worker job. The parameters are bound
+// on the worker, so that operations queued before this one keep theirs.
+// Null or undefined parameters bind nothing, and can be followed by options
+// and a callback just like an array.
+function runSingleRow(statement, run, params, options, callback) {
+	if (params === undefined || params === null) {
+		params = null;
+	} else if (typeof params === 'function' || (typeof params === 'object' && !Array.isArray(params))) {
+		callback = options;
+		options = params;
+		params = null;
+	} else if (!Array.isArray(params)) {
+		throw new Error('Parameters must be an array.');
+	}
+
+	if (params) {
+		statement.bindParameterCursor = 1;
+	}
+	return runOnWorker(statement, run, options, callback, identity, params);
+}
+
+// Returns the first row as an object keyed by column name, or undefined
+// when there is none. Takes the same options as step.
+LowLevelStatement.prototype.get = function(params, options, callback) {
+	return runSingleRow(this, getRow, params, options, callback);
+};
+
+// Like get, but returns only the first column of the first row.
+LowLevelStatement.prototype.pluck = function(params, options, callback) {
+	return runSingleRow(this, pluckValue, params, options, callback);
+};
+
+function runColumns(statementWrapper, lane, timeout, extra, onColumns) {
+	addon.columns(statementWrapper, lane, timeout, onColumns);
+}
+
+// Like all, but returns { length, columns } with one entry per column. Number
+// columns carry a Float64Array of values and a lossy flag, set when an
+// integer was too large for a double to hold exactly. Text and blob columns
+// carry a Uint32Array of offsets into a Uint8Array of UTF-8 or raw data, and
+// every column a Uint8Array bitmap with a bit set for each null row.
+function columnsResult(columns, length) {
+	return {
+		length: length,
+		columns: columns
+	};
+}
+
+LowLevelStatement.prototype.columns = function(options, callback) {
+	return runOnWorker(this, runColumns, options, callback, columnsResult);
+};
+
+// Fetches a batch of at most batchRows rows or about batchBytes bytes, packed
+// into a single Buffer on the worker, and returns a PackedReader over it. The
+// reader's done flag tells whether the statement has run to completion.
+function runPacked(statementWrapper, lane, timeout, options, onBatch) {
+	var batchRows = (options && options.batchRows) || DEFAULT_BATCH_ROWS;
+	var batchBytes = (options && options.batchBytes) || DEFAULT_BATCH_BYTES;
+	addon.fetchPacked(statementWrapper, batchRows, batchBytes, lane, timeout, onBatch);
+}
+
+function packedReader(buffer, names, done) {
+	return new PackedReader(buffer, names, done);
+}
+
+LowLevelStatement.prototype.fetchPacked = function(options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+	return runOnWorker(this, runPacked, options, callback, packedReader, options);
+};
+
+// Like the step handler, fills complete through one function per statement
+// so that polling with fillInto allocates nothing per call.
+function makeFillHandler(statement) {
+	return function onFill(errorCode, rows) {
+		var callback = statement.fillCallback;
+		var reject = statement.fillReject;
+		statement.fillCallback = null;
+		statement.fillReject = null;
+		if (errorCode === errorCodes.SQLITE_DONE || errorCode === errorCodes.SQLITE_ROW) {
+			if (reject !== null) {
+				callback(rows);
+			} else {
+				callback(null, rows);
+			}
+		} else if (reject !== null) {
+			reject(makeError(errorCode));
+		} else {
+			callback(makeError(errorCode), 0);
+		}
+	};
+}
+
+// Steps up to maxRows times, writing each numeric column named in targets
+// into the typed array under that name, and returns the number of rows
+// written. Rows are also bounded by the shortest array. Nulls are written as
+// NaN to Float64Array and Float32Array targets and 0 to Int32Array and
+// Uint32Array ones. The statement is reset once it runs to completion.
+// Takes the same options as step.
+LowLevelStatement.prototype.fillInto = function(targets, maxRows, options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	if (maxRows !== parseInt(maxRows, 10) || maxRows < 0) {
+		throw new Error('Row limit must be a non-negative integer.');
+	}
+
+	if (this.fillCallback !== null) {
+		throw new Error('A fill is already in progress on this statement.');
+	}
+
+	var lane = priorityLane(options);
+	var timeout = operationTimeout(options);
+	var promise = promiseUnless(callback);
+	addon.fillInto(this.statementWrapper, targets, maxRows, lane, timeout, this.onFill);
+	if (promise === undefined) {
+		this.fillCallback = callback;
+	} else {
+		this.fillCallback = settlers.resolve;
+		this.fillReject = settlers.reject;
+	}
+	return promise;
+};
+
+// Returns a Readable stream of row objects. Rows are fetched on a worker in
+// batches of at most batchRows rows or about batchBytes bytes, and the next
+// batch is only fetched once the consumer has drained the previous one.
+// Also takes the priority and timeout options, applied to each batch, and
+// the lazy and intern options of all.
+LowLevelStatement.prototype.stream = function(options) {
+	return new RowStream(this, options || {});
+};
+
+// Cancels the running operation of this statement, or the next one to run.
+// Its callback receives an SQLITE_INTERRUPT error. Operations of a statement
+// run one at a time in order, so later ones are left alone. Returns false if
+// nothing was left to run.
+LowLevelStatement.prototype.abort = function() {
+	return addon.cancel(this.statementWrapper);
+};
+
+LowLevelStatement.prototype.stepSync = function() {
+	var errorCode = addon.stepSync(this.statementWrapper);
+	switch (errorCode) {
+		case errorCodes.SQLITE_OK:
+		case errorCodes.SQLITE_ROW:
+		case errorCodes.SQLITE_DONE:
+			return errorCode;
+		default:
+			throw makeError(errorCode);
+	}
+};
+
+// Steps the statement until it stops returning rows, then resets it.
+LowLevelStatement.prototype.runSync = function(values) {
+	this.bindAll(values);
+	this.bindParameterCursor = 1;
+	var errorCode = addon.runSync(this.statementWrapper);
+	if (errorCode !== errorCodes.SQLITE_DONE) {
+		throw makeError(errorCode);
+	}
+	return errorCode;
+};
+
+// Counts of steps run on the loop thread and on workers, along with the
+// moving average of the step time in microseconds.
+LowLevelStatement.prototype.stepStats = function() {
+	return addon.stepStats(this.statementWrapper);
 };
 
 LowLevelStatement.prototype.columnCount = function() {
@@ -112,20 +567,29 @@ LowLevelStatement.prototype.columnText = function(columnIndex) {
 	return addon.columnText(this.statementWrapper, columnIndex);
 };
 
-LowLevelStatement.prototype.column = function(columnIndex) {
-	var columnType = this.columnType(columnIndex);
-	switch (columnType) {
-		case datatypeCodes.SQLITE_INTEGER:
-			return this.columnInteger(columnIndex);
-		case datatypeCodes.SQLITE_FLOAT:
-			return this.columnFloat(columnIndex);
-		case datatypeCodes.SQLITE_TEXT:
-			return this.columnText(columnIndex);
-		case datatypeCodes.SQLITE_NULL:
-			return null;
-		default:
-			throw new Error("Unsupported data type: " + columnType);
+LowLevelStatement.prototype.columnBlob = function(columnIndex) {
+	return addon.columnBlob(this.statementWrapper, columnIndex);
+};
+
+var rowModes = {
+	array: 0,
+	object: 1
+};
+
+// Returns the current row in a single native call, as an object keyed by
+// column name or, with the 'array' mode, as an array.
+LowLevelStatement.prototype.readRow = function(mode) {
+	if (mode === undefined) {
+		mode = 'object';
+	} else if (!rowModes.hasOwnProperty(mode)) {
+		throw new Error('Unknown row mode: ' + mode);
 	}
+	return addon.row(this.statementWrapper, rowModes[mode]);
+};
+
+// Decodes the column in a single native call, whatever its type.
+LowLevelStatement.prototype.column = function(columnIndex) {
+	return addon.columnValue(this.statementWrapper, columnIndex);
 };
 
 LowLevelStatement.prototype.clearBindings = function() {
@@ -149,25 +613,171 @@ LowLevelStatement.prototype.finalize = function() {
 	}
 };
 
-function open(filename, callback) {
-	var dbWrapper = new addon.DbWrapper();
-	addon.open(dbWrapper, filename, function(errorCode) {
-		if (errorCode === errorCodes.SQLITE_OK) {
-			var db = new LowLevelDb(dbWrapper);
-			callback(null, db);
-		} else {
-			callback(makeError(errorCode), null);
-		}
+function RowStream(statement, options) {
+	this.batchRows = options.batchRows || DEFAULT_BATCH_ROWS;
+	this.batchBytes = options.batchBytes || DEFAULT_BATCH_BYTES;
+	this.lane = priorityLane(options);
+	this.timeout = operationTimeout(options);
+	this.flags = resultFlags(options);
+	Readable.call(this, {
+		objectMode: true,
+		highWaterMark: this.batchRows
 	});
+
+	this.statement = statement;
+	this.fetching = false;
+	this.readRequested = false;
+	this.done = false;
+	this.destroyed = false;
+	this.onBatch = makeBatchHandler(this);
+}
+
+util.inherits(RowStream, Readable);
+
+function makeBatchHandler(stream) {
+	return function onBatch(errorCode, rows) {
+		if (stream.destroyed) {
+			stream.fetching = false;
+			stream.statement.reset();
+			return;
+		}
+
+		if (errorCode !== errorCodes.SQLITE_ROW && errorCode !== errorCodes.SQLITE_DONE) {
+			stream.done = true;
+			stream.fetching = false;
+			stream.statement.reset();
+			stream.emit('error', makeError(errorCode));
+			return;
+		}
+
+		stream.done = errorCode === errorCodes.SQLITE_DONE;
+		for (var i = 0; i < rows.length; i++) {
+			stream.push(rows[i]);
+		}
+
+		// The consumer may ask for more while the rows above are pushed, and
+		// will then wait for a push that only the next batch can provide.
+		stream.fetching = false;
+		if (stream.done) {
+			stream.push(null);
+		} else if (stream.readRequested) {
+			stream.readRequested = false;
+			stream._read();
+		}
+	};
+}
+
+RowStream.prototype._read = function() {
+	if (this.done) {
+		return;
+	}
+
+	if (this.fetching) {
+		this.readRequested = true;
+		return;
+	}
+
+	this.fetching = true;
+	addon.fetchBatch(this.statement.statementWrapper, this.batchRows, this.batchBytes, this.lane, this.timeout, this.flags, this.onBatch);
+};
+
+// Stops the stream before it has run to completion and resets the statement,
+// which would otherwise stay in the middle of its rows. A batch still being
+// fetched is dropped once it arrives.
+RowStream.prototype.destroy = function() {
+	if (this.destroyed) {
+		return;
+	}
+
+	this.destroyed = true;
+	this.done = true;
+	if (!this.fetching) {
+		this.statement.reset();
+	}
+	this.emit('close');
+};
+
+// With `dedicatedThread`, every operation on the connection runs in order on
+// a thread of its own and SQLite's per-connection mutex is skipped.
+// Synchronous calls must then not overlap a pending asynchronous one.
+// Returns a promise when no callback is given.
+function open(filename, options, callback) {
+	if (typeof options === 'function' && callback === undefined) {
+		callback = options;
+		options = null;
+	}
+
+	var dedicatedThread = !!(options && options.dedicatedThread);
+	var db = new LowLevelDb(new addon.DbWrapper());
+	var promise = promiseUnless(callback);
+	addon.open(db.dbWrapper, filename, dedicatedThread, onComplete);
+	queueCompletion(db.dbWrapper, db, callback);
+	return promise;
 }
 
 function version() {
 	return addon.version();
 }
 
+function setPromiseConstructor(constructor) {
+	if (typeof constructor !== 'function') {
+		throw new Error('Promise constructor must be a function.');
+	}
+	PromiseConstructor = constructor;
+}
+
+// Number of native operation records and persistent handles allocated so
+// far, for checking that a steady workload allocates nothing per call.
+function allocationCount() {
+	return addon.allocationCount();
+}
+
+function poolSize() {
+	return addon.poolSize();
+}
+
+function setPoolSize(size) {
+	if (size !== parseInt(size, 10) || size < 1) {
+		throw new Error('Pool size must be a positive integer.');
+	}
+
+	if (!addon.setPoolSize(size)) {
+		throw new Error('Pool size can only be changed before the first operation, and to at most 128 threads.');
+	}
+}
+
+// Number of operations waiting in each priority lane of the shared pool.
+function queueDepths() {
+	return addon.queueDepths();
+}
+
+function inlineStepThreshold() {
+	return addon.inlineStepThreshold();
+}
+
+// Statements whose steps take less than this many microseconds on average
+// are stepped on the loop thread. Zero, the default, always uses workers.
+function setInlineStepThreshold(microseconds) {
+	if (typeof microseconds !== 'number' || microseconds < 0) {
+		throw new Error('Threshold must be a non-negative number.');
+	}
+	addon.setInlineStepThreshold(microseconds);
+}
+
+if (process.env.BETTER_SQLITE_POOL_SIZE) {
+	setPoolSize(parseInt(process.env.BETTER_SQLITE_POOL_SIZE, 10));
+}
+
 module.exports = {
+	allocationCount: allocationCount,
 	datatypeCodes: datatypeCodes,
 	errorCodes: errorCodes,
+	inlineStepThreshold: inlineStepThreshold,
 	open: open,
+	poolSize: poolSize,
+	queueDepths: queueDepths,
+	setInlineStepThreshold: setInlineStepThreshold,
+	setPoolSize: setPoolSize,
+	setPromiseConstructor: setPromiseConstructor,
 	version: version
 };
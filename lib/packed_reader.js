@@ -0,0 +1,99 @@
+var datatypeCodes = require('./datatype_codes.js');
+
+// Layout of a packed batch, mirroring the PACKED_* sizes in src/results.h.
+var HEADER_SIZE = 8;
+var TAG_SIZE = 1;
+var NUMBER_SIZE = 8;
+var LENGTH_SIZE = 4;
+var NUMBER_CELL_SIZE = TAG_SIZE + NUMBER_SIZE;
+var LENGTH_PREFIXED_CELL_SIZE = TAG_SIZE + LENGTH_SIZE;
+var UINT32_RANGE = 4294967296;
+
+function cellSize(buffer, offset) {
+	switch (buffer[offset]) {
+		case datatypeCodes.SQLITE_INTEGER:
+		case datatypeCodes.SQLITE_FLOAT:
+			return NUMBER_CELL_SIZE;
+		case datatypeCodes.SQLITE_TEXT:
+		case datatypeCodes.SQLITE_BLOB:
+			return LENGTH_PREFIXED_CELL_SIZE + buffer.readUInt32LE(offset + TAG_SIZE);
+		default:
+			return TAG_SIZE;
+	}
+}
+
+// Reads a packed batch one row at a time. Values are only decoded when asked
+// for, and blobs are slices sharing the batch's memory.
+function PackedReader(buffer, names, done) {
+	this.buffer = buffer;
+	this.names = names;
+	this.done = done;
+	this.length = buffer.readUInt32LE(0);
+	this.columnCount = buffer.readUInt32LE(4);
+	this.index = -1;
+	this.nextOffset = HEADER_SIZE;
+	this.cellOffsets = new Array(this.columnCount);
+}
+
+// Moves to the next row, returning false once past the last one.
+PackedReader.prototype.next = function() {
+	if (this.index + 1 >= this.length) {
+		this.index = this.length;
+		return false;
+	}
+
+	var offset = this.nextOffset;
+	for (var i = 0; i < this.columnCount; i++) {
+		this.cellOffsets[i] = offset;
+		offset += cellSize(this.buffer, offset);
+	}
+
+	this.nextOffset = offset;
+	this.index++;
+	return true;
+};
+
+PackedReader.prototype.type = function(columnIndex) {
+	return this.buffer[this.cellOffsets[columnIndex]];
+};
+
+// Integers are exact up to 2^53, as with columnInteger.
+PackedReader.prototype.value = function(columnIndex) {
+	var buffer = this.buffer;
+	var offset = this.cellOffsets[columnIndex];
+	var payload = offset + TAG_SIZE;
+	var start = offset + LENGTH_PREFIXED_CELL_SIZE;
+
+	switch (buffer[offset]) {
+		case datatypeCodes.SQLITE_INTEGER:
+			// the high half of the int64 follows its low half
+			return buffer.readInt32LE(payload + 4) * UINT32_RANGE + buffer.readUInt32LE(payload);
+		case datatypeCodes.SQLITE_FLOAT:
+			return buffer.readDoubleLE(payload);
+		case datatypeCodes.SQLITE_TEXT:
+			return buffer.toString('utf8', start, start + buffer.readUInt32LE(payload));
+		case datatypeCodes.SQLITE_BLOB:
+			return buffer.slice(start, start + buffer.readUInt32LE(payload));
+		default:
+			return null;
+	}
+};
+
+PackedReader.prototype.row = function() {
+	var row = {};
+	for (var i = 0; i < this.columnCount; i++) {
+		row[this.names[i]] = this.value(i);
+	}
+	return row;
+};
+
+// Decodes the remaining rows into objects keyed by column name.
+PackedReader.prototype.toArray = function() {
+	var rows = [];
+	while (this.next()) {
+		rows.push(this.row());
+	}
+	return rows;
+};
+
+module.exports = PackedReader;
@@ -1,10 +1,17 @@
+#include <cstring>
 #include <limits>
+#include <vector>
 #include <node.h>
+#include <node_buffer.h>
 #include <uv.h>
 #include <v8.h>
 #include "bindings.h"
+#include "completion.h"
 #include "db.h"
 #include "db_wrapper.h"
+#include "pool.h"
+#include "result_wrapper.h"
+#include "results.h"
 #include "statement.h"
 #include "statement_wrapper.h"
 
@@ -12,6 +19,68 @@
 
 using namespace v8;
 
+// Argument selecting the priority lane of an operation, which keeps the
+// default lane when undefined. Callbacks always come last.
+static pool_lane_t LaneArgument(const Arguments& args, int index, pool_lane_t default_lane) {
+	if (args.Length() <= index || !args[index]->IsInt32()) {
+		return default_lane;
+	}
+	return args[index]->Int32Value() == pool_lane_background ? pool_lane_background : pool_lane_interactive;
+}
+
+// Argument with a timeout in milliseconds, turned into an absolute deadline
+// for the operation. Zero or undefined means no deadline.
+static uint64_t DeadlineArgument(const Arguments& args, int index) {
+	if (args.Length() <= index || !args[index]->IsNumber() || args[index]->NumberValue() <= 0) {
+		return 0;
+	}
+	return uv_hrtime() + static_cast<uint64_t>(args[index]->NumberValue() * 1000000.0);
+}
+
+// Callback argument, held in a new persistent handle until the operation
+// completes. Each handle is counted in async_allocation_count.
+static Function *CallbackArgument(const Arguments& args, int index) {
+	async_allocation_count++;
+	return *Persistent<Function>::New(Handle<Function>::Cast(args[index]));
+}
+
+// Callback argument, for operations that complete through the same function
+// every time. The first function passed is kept in `cached` until it is
+// released, so callers that always pass that one never create another
+// persistent handle. Any other function gets a handle of its own, which the
+// completion disposes when `owned` is set.
+static Function *CachedCallbackArgument(Handle<Value> value, Persistent<Function>& cached, int *owned) {
+	auto callback = Handle<Function>::Cast(value);
+	if (cached.IsEmpty()) {
+		cached = Persistent<Function>::New(callback);
+		async_allocation_count++;
+	}
+	
+	if (cached->StrictEquals(callback)) {
+		return *cached;
+	}
+	*owned = 1;
+	async_allocation_count++;
+	return *Persistent<Function>::New(callback);
+}
+
+// Open, close and prepare all complete through the database layer's single
+// handler, which tells them apart by the wrapper passed back to it.
+static Persistent<Function> completion_callback;
+
+// Argument with the flags of a whole-result or batch fetch, zero when
+// undefined.
+enum ResultFlags {
+	RESULT_FLAG_LAZY = 1,
+	RESULT_FLAG_INTERN = 2
+};
+
+static void ResultFlagsArgument(const Arguments& args, int index, query_baton_t *baton) {
+	const int flags = args.Length() > index && args[index]->IsInt32() ? args[index]->Int32Value() : 0;
+	baton->lazy = (flags & RESULT_FLAG_LAZY) != 0;
+	baton->intern = (flags & RESULT_FLAG_INTERN) != 0;
+}
+
 static Handle<Value> ErrMsg(const Arguments& args) {
 	HandleScope scope;
 	if (args.Length() < 1) {
@@ -90,29 +159,93 @@ static Handle<Value> ClearBindings(const Arguments& args) {
 	
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
     const auto error_code = clear_bindings_sync(statement_wrapper->statement);
+	statement_wrapper->UnpinBindings();
     return scope.Close(Integer::New(error_code));
 }
 
-static int BindValue(statement_t *stmt, const int index, Handle<Value> value) {
-	if (value->IsInt32()) {
-		return bind_int_sync(stmt, index, value->Int32Value());
+// Buffers, and Uint8Arrays which share their representation in this node,
+// keep their bytes outside the V8 heap, so they can be bound in place.
+static bool IsByteArray(Handle<Value> value) {
+	if (!value->IsObject()) {
+		return false;
+	}
+	
+	auto object = Handle<Object>::Cast(value);
+	return object->HasIndexedPropertiesInExternalArrayData() &&
+		object->GetIndexedPropertiesExternalArrayDataType() == kExternalUnsignedByteArray;
+}
+
+static int BindValue(StatementWrapper *wrapper, const int index, Handle<Value> value) {
+	statement_t *stmt = wrapper->statement;
+	Handle<Object> pin;
+	int result;
+	if (IsByteArray(value)) {
+		pin = Handle<Object>::Cast(value);
+		result = bind_blob_sync(stmt, index, pin->GetIndexedPropertiesExternalArrayData(),
+			pin->GetIndexedPropertiesExternalArrayDataLength());
+	} else if (value->IsInt32()) {
+		result = bind_int_sync(stmt, index, value->Int32Value());
 	} else if (value->IsNumber()) {
 		const auto double_value = value->NumberValue();
 		const auto int64_value = value->IntegerValue();
 		
 		if ((double)int64_value == double_value) {
-			return bind_int64_sync(stmt, index, int64_value);
+			result = bind_int64_sync(stmt, index, int64_value);
 		} else {
-			return bind_double_sync(stmt, index, double_value);
+			result = bind_double_sync(stmt, index, double_value);
 		}
 	} else if (value->IsString()) {
 		auto text = value->ToString();
-		return bind_text_sync(stmt, index, strdup(*v8::String::Utf8Value(text)), text->Utf8Length());
+		result = bind_text_sync(stmt, index, strdup(*v8::String::Utf8Value(text)), text->Utf8Length());
 	} else if (value->IsNull()) {
-		return bind_null_sync(stmt, index);
+		result = bind_null_sync(stmt, index);
 	} else {
 		return BS_UNKNOWN_TYPE;
 	}
+	
+	// a failed bind leaves the previous value bound, along with its pin
+	if (result == SQLITE_OK) {
+		wrapper->PinBinding(index, pin);
+	}
+	return result;
+}
+
+// Copies a parameter for binding on a worker, converting it the way
+// BindValue does. Returns false for unsupported types.
+static bool CopyParam(Handle<Value> value, record_t *param) {
+	if (IsByteArray(value)) {
+		auto object = Handle<Object>::Cast(value);
+		const size_t length = static_cast<size_t>(object->GetIndexedPropertiesExternalArrayDataLength());
+		param->type = record_type_blob;
+		param->value.blob_value.length = length;
+		param->value.blob_value.data = malloc(length > 0 ? length : 1); // NULL would bind a null
+		memcpy(param->value.blob_value.data, object->GetIndexedPropertiesExternalArrayData(), length);
+	} else if (value->IsInt32()) {
+		param->type = record_type_integer;
+		param->value.integer_value = value->Int32Value();
+	} else if (value->IsNumber()) {
+		const auto double_value = value->NumberValue();
+		const auto int64_value = value->IntegerValue();
+		
+		if ((double)int64_value == double_value) {
+			param->type = record_type_integer;
+			param->value.integer_value = int64_value;
+		} else {
+			param->type = record_type_float;
+			param->value.float_value = double_value;
+		}
+	} else if (value->IsString()) {
+		v8::String::Utf8Value text(value);
+		param->type = record_type_text;
+		param->value.text_value.length = static_cast<size_t>(text.length());
+		param->value.text_value.text = static_cast<char*>(malloc(text.length() + 1));
+		memcpy(param->value.text_value.text, *text, text.length() + 1);
+	} else if (value->IsNull()) {
+		param->type = record_type_null;
+	} else {
+		return false;
+	}
+	return true;
 }
 
 static Handle<Value> Bind(const Arguments& args) {
@@ -134,7 +267,7 @@ static Handle<Value> Bind(const Arguments& args) {
 	
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
 	const auto index = args[2]->Int32Value();
-	const auto binding_result = BindValue(statement_wrapper->statement, index, args[1]);
+	const auto binding_result = BindValue(statement_wrapper, index, args[1]);
 	
 	if (binding_result != BS_UNKNOWN_TYPE) {
 		return scope.Close(Integer::New(binding_result));
@@ -184,6 +317,16 @@ static Handle<Value> ColumnType(const Arguments& args) {
     return scope.Close(Integer::New(columnDatatypeCode));
 }
 
+// Small integers become V8 Integers, the rest doubles. This V8 has no BigInt,
+// so integers beyond 2^53 in magnitude are rounded to the nearest double.
+static Local<Value> IntegerValue(long long value) {
+	if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max()) {
+		return Local<Value>::New(Integer::New(static_cast<int32_t>(value)));
+	} else {
+		return Local<Value>::New(Number::New(static_cast<double>(value)));
+	}
+}
+
 static Handle<Value> ColumnInteger(const Arguments& args) {
 	HandleScope scope;
 	if (args.Length() < 2) {
@@ -204,12 +347,7 @@ static Handle<Value> ColumnInteger(const Arguments& args) {
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
 	const auto column_index = args[1]->Int32Value();
     const auto int64value = column_int64_sync(statement_wrapper->statement, column_index);
-	
-	if (int64value <= std::numeric_limits<int32_t>::max()) {
-		return scope.Close(Integer::New(static_cast<int>(int64value)));
-	} else {
-		return scope.Close(Number::New(static_cast<double>(int64value)));
-	}
+	return scope.Close(IntegerValue(int64value));
 }
 
 static Handle<Value> ColumnFloat(const Arguments& args) {
@@ -255,7 +393,117 @@ static Handle<Value> ColumnText(const Arguments& args) {
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
 	const auto column_index = args[1]->Int32Value();
     const auto value = column_text_sync(statement_wrapper->statement, column_index);
-	return scope.Close(String::New(value));
+	const auto length = column_bytes_sync(statement_wrapper->statement, column_index);
+	return scope.Close(String::New(value, length));
+}
+
+// Decodes a column of the current row according to its storage class.
+// sqlite does not enforce declared types, so the class is read per cell.
+static Local<Value> CellValue(statement_t *statement, int column_index) {
+	switch (column_type_sync(statement, column_index)) {
+		case SQLITE_INTEGER:
+			return IntegerValue(column_int64_sync(statement, column_index));
+		case SQLITE_FLOAT:
+			return Local<Value>::New(Number::New(column_double_sync(statement, column_index)));
+		case SQLITE_TEXT: {
+			const auto text = column_text_sync(statement, column_index);
+			return Local<Value>::New(String::New(text, column_bytes_sync(statement, column_index)));
+		}
+		case SQLITE_BLOB: {
+			const auto blob = column_blob_sync(statement, column_index);
+			const auto length = static_cast<size_t>(column_bytes_sync(statement, column_index));
+			return Local<Value>::New(node::Buffer::New(static_cast<const char*>(blob), length)->handle_);
+		}
+		case SQLITE_NULL:
+		default:
+			return Local<Value>::New(Null());
+	}
+}
+
+static Handle<Value> ColumnValue(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 2) {
+		ThrowException(Exception::TypeError(String::New("Expected at least two arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsInt32()) {
+	    ThrowException(Exception::TypeError(String::New("Second argument must be an integer.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	return scope.Close(CellValue(statement_wrapper->statement, args[1]->Int32Value()));
+}
+
+enum RowMode {
+	ROW_MODE_ARRAY = 0,
+	ROW_MODE_OBJECT = 1
+};
+
+// Returns the current row as an array, or as an object built from the
+// statement's row template.
+static Handle<Value> Row(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto statement = statement_wrapper->statement;
+	const int column_count = column_count_sync(statement);
+	const bool as_object = args.Length() > 1 && args[1]->Int32Value() == ROW_MODE_OBJECT;
+	
+	if (as_object) {
+		auto row = statement_wrapper->NewRow(column_count);
+		for (int i = 0; i < column_count; i++) {
+			row->Set(statement_wrapper->ColumnName(i), CellValue(statement, i));
+		}
+		return scope.Close(row);
+	} else {
+		auto row = Array::New(column_count);
+		for (int i = 0; i < column_count; i++) {
+			row->Set(static_cast<uint32_t>(i), CellValue(statement, i));
+		}
+		return scope.Close(row);
+	}
+}
+
+// Copies the blob, since sqlite only keeps it until the next step.
+static Handle<Value> ColumnBlob(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 2) {
+		ThrowException(Exception::TypeError(String::New("Expected at least two arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsInt32()) {
+	    ThrowException(Exception::TypeError(String::New("Second argument must be an integer.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	const auto column_index = args[1]->Int32Value();
+	const auto value = column_blob_sync(statement_wrapper->statement, column_index);
+	const auto length = column_bytes_sync(statement_wrapper->statement, column_index);
+	auto buffer = node::Buffer::New(static_cast<const char*>(value), static_cast<size_t>(length));
+	return scope.Close(buffer->handle_);
 }
 
 static Handle<Value> Reset(const Arguments& args) {
@@ -297,6 +545,31 @@ static Handle<Value> Version(const Arguments& args) {
 	return scope.Close(String::New(libversion_sync()));
 }
 
+static Handle<Value> AllocationCount(const Arguments& args) {
+	HandleScope scope;
+	return scope.Close(Number::New(static_cast<double>(async_allocation_count)));
+}
+
+static Handle<Value> PoolSize(const Arguments& args) {
+	HandleScope scope;
+	return scope.Close(Integer::NewFromUnsigned(pool_size()));
+}
+
+static Handle<Value> SetPoolSize(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsUint32()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be a positive integer.")));
+	    return scope.Close(Undefined());
+	}
+	
+	return scope.Close(Boolean::New(pool_set_size(args[0]->Uint32Value()) == 0));
+}
+
 static Handle<Value> Finalize(const Arguments& args) {
 	HandleScope scope;
 	if (args.Length() < 1) {
@@ -311,25 +584,35 @@ static Handle<Value> Finalize(const Arguments& args) {
 	
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
 	const auto error_code = finalize_sync(statement_wrapper->statement);
+	
+	// a step still in flight completes through the cached step callback
+	if (statement_wrapper->statement->task_count == 0) {
+		statement_wrapper->ReleaseHandles();
+	}
 	return scope.Close(Integer::New(error_code));
 }
 
 static void OpenCallback(open_baton_t *baton) {
+	auto db_wrapper = static_cast<DbWrapper*>(baton->wrapper);
 	Local<Value> args[] = {
-		Local<Value>::New(Integer::New(baton->result))
+		Local<Value>::New(Integer::New(baton->result)),
+		Local<Value>::New(db_wrapper->handle_)
 	};
 	
 	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
-	callback->Call(Context::GetCurrent()->Global(), 1, args);
-	callback.Dispose();
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	db_wrapper->Unref();
 	open_baton_free(baton);
 }
 
 static Handle<Value> Open(const Arguments& args) {
 	HandleScope scope;
 	
-	if (args.Length() < 3) {
-		ThrowException(Exception::TypeError(String::New("Expected at least three arguments.")));
+	if (args.Length() < 4) {
+		ThrowException(Exception::TypeError(String::New("Expected at least four arguments.")));
 	    return scope.Close(Undefined());
 	}
 	
@@ -343,20 +626,26 @@ static Handle<Value> Open(const Arguments& args) {
 	    return scope.Close(Undefined());
 	}
 	
-	if (!args[2]->IsFunction()) {
-	    ThrowException(Exception::TypeError(String::New("Third argument must be a function.")));
+	if (!args[2]->IsBoolean()) {
+	    ThrowException(Exception::TypeError(String::New("Third argument must be a boolean.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[3]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fourth argument must be a function.")));
 	    return scope.Close(Undefined());
 	}
 	
 	auto db_wrapper = node::ObjectWrap::Unwrap<DbWrapper>(Handle<Object>::Cast(args[0]));
-	auto db = db_new();
+	auto db = db_new(args[2]->BooleanValue() ? 1 : 0);
 	auto baton = open_baton_new();
 	
-	baton->req.data = baton;
 	baton->db = db;
 	baton->filename = strdup(*v8::String::Utf8Value(args[1]->ToString()));
 	baton->c_callback = OpenCallback;
-	baton->js_callback = *Persistent<Function>::New(Handle<Function>::Cast(args[2]));
+	baton->js_callback = CachedCallbackArgument(args[3], completion_callback, &baton->js_callback_owned);
+	baton->wrapper = db_wrapper;
+	db_wrapper->Ref();
 	db_wrapper->db = db;
 	open_async(baton);
 	
@@ -364,13 +653,22 @@ static Handle<Value> Open(const Arguments& args) {
 }
 
 static void CloseCallback(close_baton_t *baton) {
+	auto db_wrapper = static_cast<DbWrapper*>(baton->wrapper);
 	Local<Value> args[] = {
-		Local<Value>::New(Integer::New(baton->result))
+		Local<Value>::New(Integer::New(baton->result)),
+		Local<Value>::New(db_wrapper->handle_)
 	};
 	
+	if (baton->result == SQLITE_OK) {
+		db_stop_worker(baton->db);
+	}
+	
 	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
-	callback->Call(Context::GetCurrent()->Global(), 1, args);
-	callback.Dispose();
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	db_wrapper->Unref();
 	close_baton_free(baton);
 }
 
@@ -395,31 +693,37 @@ static Handle<Value> Close(const Arguments& args) {
 	auto db_wrapper = node::ObjectWrap::Unwrap<DbWrapper>(Handle<Object>::Cast(args[0]));
 	auto baton = close_baton_new();
 	
-	baton->req.data = baton;
 	baton->db = db_wrapper->db;
 	baton->c_callback = CloseCallback;
-	baton->js_callback = *Persistent<Function>::New(Handle<Function>::Cast(args[1]));
+	baton->js_callback = CachedCallbackArgument(args[1], completion_callback, &baton->js_callback_owned);
+	baton->wrapper = db_wrapper;
+	db_wrapper->Ref();
 	close_async(baton);
 	
 	return scope.Close(Undefined());
 }
 
 static void PrepareCallback(prepare_baton_t *baton) {	
+	auto statement_wrapper = static_cast<StatementWrapper*>(baton->wrapper);
 	Local<Value> args[] = {
-		Local<Value>::New(Integer::New(baton->result))
+		Local<Value>::New(Integer::New(baton->result)),
+		Local<Value>::New(statement_wrapper->handle_)
 	};
 	
 	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
-	callback->Call(Context::GetCurrent()->Global(), 1, args);
-	callback.Dispose();
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	statement_wrapper->Unref();
 	prepare_baton_free(baton);
 }
 
 static Handle<Value> Prepare(const Arguments& args) {
 	HandleScope scope;
 	
-	if (args.Length() < 4) {
-		ThrowException(Exception::TypeError(String::New("Expected at least three arguments.")));
+	if (args.Length() < 5) {
+		ThrowException(Exception::TypeError(String::New("Expected at least five arguments.")));
 	    return scope.Close(Undefined());
 	}
 	
@@ -438,25 +742,28 @@ static Handle<Value> Prepare(const Arguments& args) {
 	    return scope.Close(Undefined());
 	}
 	
-	if (!args[3]->IsFunction()) {
-	    ThrowException(Exception::TypeError(String::New("Fourth argument must be a function.")));
+	if (!args[4]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fifth argument must be a function.")));
 	    return scope.Close(Undefined());
 	}
 	
 	auto db_wrapper = node::ObjectWrap::Unwrap<DbWrapper>(Handle<Object>::Cast(args[0]));
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[1]));
 	
-	auto statement = statement_new();
+	auto statement = statement_new(db_wrapper->db);
 	auto baton = prepare_baton_new();
 	auto sql = args[2]->ToString();
 	
-	baton->req.data = baton;
 	baton->db = db_wrapper->db;
 	baton->statement = statement;
 	baton->sql = strdup(*v8::String::Utf8Value(sql));
 	baton->sql_length = sql->Utf8Length();
 	baton->c_callback = PrepareCallback;
-	baton->js_callback = *Persistent<Function>::New(Handle<Function>::Cast(args[3]));
+	baton->js_callback = CachedCallbackArgument(args[4], completion_callback, &baton->js_callback_owned);
+	baton->wrapper = statement_wrapper;
+	statement_wrapper->Ref();
+	baton->task.lane = LaneArgument(args, 3, pool_lane_interactive);
+	statement->lane = baton->task.lane;
 	statement_wrapper->statement = statement;
 	prepare_async(baton);
 	
@@ -465,20 +772,36 @@ static Handle<Value> Prepare(const Arguments& args) {
 
 static void StepCallback(step_baton_t *baton) {	
 	Local<Value> args[] = {
-		Local<Value>::New(Integer::New(baton->result))
+		Local<Value>::New(Integer::New(baton->result)),
+		Local<Value>::New(Integer::New(baton->rows))
 	};
 	
 	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
-	callback->Call(Context::GetCurrent()->Global(), 1, args);
-	callback.Dispose();
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
 	step_baton_free(baton);
 }
 
+static void StartStep(StatementWrapper *statement_wrapper, int limit, Handle<Value> callback, pool_lane_t lane, uint64_t deadline) {
+    auto baton = step_baton_new();
+    
+	baton->statement = statement_wrapper->statement;
+	baton->limit = limit;
+	baton->task.lane = lane;
+	baton->task.deadline = deadline;
+	baton->c_callback = StepCallback;
+	
+	baton->js_callback = CachedCallbackArgument(callback, statement_wrapper->step_callback, &baton->js_callback_owned);
+	step_schedule(baton);
+}
+
 static Handle<Value> Step(const Arguments& args) {
 	HandleScope scope;
 	
-	if (args.Length() < 2) {
-		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	if (args.Length() < 4) {
+		ThrowException(Exception::TypeError(String::New("Expected at least four arguments.")));
 	    return scope.Close(Undefined());
 	}
 	
@@ -487,55 +810,876 @@ static Handle<Value> Step(const Arguments& args) {
 	    return scope.Close(Undefined());
 	}
     
-	if (!args[1]->IsFunction()) {
-	    ThrowException(Exception::TypeError(String::New("Second argument must be a function.")));
+	if (!args[3]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fourth argument must be a function.")));
 	    return scope.Close(Undefined());
 	}
 	
 	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
-    auto baton = step_baton_new();
+	StartStep(statement_wrapper, 1, args[3], LaneArgument(args, 1, statement_wrapper->statement->lane), DeadlineArgument(args, 2));
+	
+	return scope.Close(Undefined());
+}
+
+static Handle<Value> StepN(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 5) {
+		ThrowException(Exception::TypeError(String::New("Expected at least five arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsInt32() || args[1]->Int32Value() < 1) {
+	    ThrowException(Exception::TypeError(String::New("Second argument must be a positive integer.")));
+	    return scope.Close(Undefined());
+	}
     
-	baton->req.data = baton;
-	baton->statement = statement_wrapper->statement;
-	baton->c_callback = StepCallback;
-	baton->js_callback = *Persistent<Function>::New(Handle<Function>::Cast(args[1]));
-	step_async(baton);
+	if (!args[4]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fifth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	StartStep(statement_wrapper, args[1]->Int32Value(), args[4], LaneArgument(args, 2, statement_wrapper->statement->lane), DeadlineArgument(args, 3));
 	
 	return scope.Close(Undefined());
 }
 
-static inline void AddFunction(Handle<Object> exports, const char *name, Handle<Value> (&function)(const Arguments&)) {
-	exports->Set(String::NewSymbol(name), FunctionTemplate::New(function)->GetFunction());
+static Handle<Value> Cancel(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	return scope.Close(Boolean::New(statement_cancel(statement_wrapper->statement) != 0));
 }
 
-static void ExportTypes(Handle<Object> exports) {
-	DbWrapper::Init(exports);
-	StatementWrapper::Init(exports);
+static Handle<Value> QueueDepths(const Arguments& args) {
+	HandleScope scope;
+	auto depths = Object::New();
+	depths->Set(String::NewSymbol("interactive"), Integer::NewFromUnsigned(pool_queue_depth(pool_lane_interactive)));
+	depths->Set(String::NewSymbol("background"), Integer::NewFromUnsigned(pool_queue_depth(pool_lane_background)));
+	return scope.Close(depths);
 }
 
-static void ExportFunctions(Handle<Object> exports) {
-	AddFunction(exports, "bind", Bind);
-	AddFunction(exports, "changes", Changes);
-	AddFunction(exports, "clearBindings", ClearBindings);
-	AddFunction(exports, "close", Close);
-	AddFunction(exports, "columnCount", ColumnCount);
-	AddFunction(exports, "columnFloat", ColumnFloat);
-	AddFunction(exports, "columnInteger", ColumnInteger);
-	AddFunction(exports, "columnText", ColumnText);
-    AddFunction(exports, "columnType", ColumnType);
-	AddFunction(exports, "errMsg", ErrMsg);
-	AddFunction(exports, "finalize", Finalize);
-	AddFunction(exports, "getAutocommit", GetAutocommit);
-	AddFunction(exports, "lastInsertRowId", LastInsertRowId);
-	AddFunction(exports, "open", Open);
-	AddFunction(exports, "prepare", Prepare);
-	AddFunction(exports, "reset", Reset);
-	AddFunction(exports, "sql", Sql);
-    AddFunction(exports, "step", Step);
-	AddFunction(exports, "version", Version);
+static Handle<Value> InlineStepThreshold(const Arguments& args) {
+	HandleScope scope;
+	return scope.Close(Number::New(statement_inline_threshold() / 1000.0));
+}
+
+static Handle<Value> SetInlineStepThreshold(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsNumber() || args[0]->NumberValue() < 0) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be a non-negative number.")));
+	    return scope.Close(Undefined());
+	}
+	
+	statement_set_inline_threshold(static_cast<uint64_t>(args[0]->NumberValue() * 1000.0));
+	return scope.Close(Undefined());
+}
+
+static Handle<Value> StepStats(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto statement = statement_wrapper->statement;
+	auto stats = Object::New();
+	stats->Set(String::NewSymbol("inline"), Number::New(static_cast<double>(statement->inline_steps)));
+	stats->Set(String::NewSymbol("offloaded"), Number::New(static_cast<double>(statement->offloaded_steps)));
+	stats->Set(String::NewSymbol("averageStepTime"), Number::New(statement->step_time_average / 1000.0));
+	return scope.Close(stats);
+}
+
+static Handle<Value> PrepareSync(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 3) {
+		ThrowException(Exception::TypeError(String::New("Expected at least three arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("Second argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[2]->IsString()) {
+	    ThrowException(Exception::TypeError(String::New("Third argument must be a string.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto db_wrapper = node::ObjectWrap::Unwrap<DbWrapper>(Handle<Object>::Cast(args[0]));
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[1]));
+	
+	auto statement = statement_new(db_wrapper->db);
+	auto sql = args[2]->ToString();
+	statement_wrapper->statement = statement;
+	
+	const auto error_code = prepare_sync(db_wrapper->db, statement, *v8::String::Utf8Value(sql), sql->Utf8Length());
+	return scope.Close(Integer::New(error_code));
+}
+
+static Handle<Value> StepSync(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	const auto error_code = step_sync(statement_wrapper->statement);
+	return scope.Close(Integer::New(error_code));
+}
+
+static Handle<Value> RunSync(const Arguments& args) {
+	HandleScope scope;
+	if (args.Length() < 1) {
+		ThrowException(Exception::TypeError(String::New("Expected at least one argument.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	const auto error_code = run_sync(statement_wrapper->statement);
+	return scope.Close(Integer::New(error_code));
+}
+
+// Text tagged ASCII, at least EXTERNAL_TEXT_MIN_LENGTH bytes long, is handed
+// to V8 as an external string over the result's arena instead of being
+// copied onto the heap.
+class ResultTextResource final : public String::ExternalAsciiStringResource {
+public:
+	ResultTextResource(result_t *result, const char *text, size_t length) : result(result), text(text), text_length(length) {
+		result_retain(result);
+	}
+	
+	~ResultTextResource() {
+		result_release(result);
+	}
+	
+	const char *data() const {
+		return text;
+	}
+	
+	size_t length() const {
+		return text_length;
+	}
+
+private:
+	result_t *result;
+	const char *text;
+	size_t text_length;
+};
+
+// ASCII text was tagged on the worker while the result was read, so the
+// loop thread does not scan it again.
+static Local<Value> TextValue(result_t *result, const char *text, size_t length, bool ascii) {
+	if (ascii) {
+		return Local<Value>::New(String::NewExternal(new ResultTextResource(result, text, length)));
+	}
+	return Local<Value>::New(String::New(text, static_cast<int>(length)));
+}
+
+static void ReleaseResultBlob(char *data, void *hint) {
+	result_release(static_cast<result_t*>(hint));
+}
+
+// The buffer adopts the blob's memory in the result arena, holding a
+// reference on the result until it is collected.
+static Local<Value> BlobValue(result_t *result, void *data, size_t length) {
+	if (length == 0) {
+		return Local<Value>::New(node::Buffer::New(0)->handle_);
+	}
+	
+	result_retain(result);
+	auto buffer = node::Buffer::New(static_cast<char*>(data), length, ReleaseResultBlob, result);
+	return Local<Value>::New(buffer->handle_);
+}
+
+typedef std::vector<Local<Value>> InternedStrings;
+
+// Interned text is only turned into a string the first time it is seen,
+// when a cache is given.
+static Local<Value> RecordValue(result_t *result, const record_t *record, InternedStrings *interned = NULL) {
+	switch (record->type) {
+		case record_type_integer:
+			return IntegerValue(record->value.integer_value);
+		case record_type_float:
+			return Local<Value>::New(Number::New(record->value.float_value));
+		case record_type_text:
+			if (interned != NULL && record->value.text_value.intern != 0) {
+				auto& cached = (*interned)[record->value.text_value.intern - 1];
+				if (cached.IsEmpty()) {
+					cached = TextValue(result, record->value.text_value.text, record->value.text_value.length,
+						record->value.text_value.ascii != 0);
+				}
+				return cached;
+			}
+			return TextValue(result, record->value.text_value.text, record->value.text_value.length,
+				record->value.text_value.ascii != 0);
+		case record_type_blob:
+			return BlobValue(result, record->value.blob_value.data, record->value.blob_value.length);
+		case record_type_null:
+		default:
+			return Local<Value>::New(Null());
+	}
+}
+
+// Converts a materialized result into an array of objects keyed by column
+// name. The names are only looked up once for the whole result.
+static Local<Array> ResultRows(StatementWrapper *wrapper, result_t *result) {
+	const int column_count = column_count_sync(wrapper->statement);
+	std::vector<Local<String>> names(column_count);
+	for (int i = 0; i < column_count; i++) {
+		names[i] = String::NewSymbol(statement_column_name(wrapper->statement, i));
+	}
+	
+	InternedStrings interned(result->interns.count);
+	auto rows = Array::New(static_cast<int>(result->length));
+	for (size_t i = 0; i < result->length; i++) {
+		const row_t *row = result->rows + i;
+		auto object = wrapper->NewRow(column_count);
+		for (size_t j = 0; j < row->length; j++) {
+			object->Set(names[j], RecordValue(result, row->records + j, &interned));
+		}
+		rows->Set(static_cast<uint32_t>(i), object);
+	}
+	return rows;
+}
+
+// Decodes a column of a lazy row on first access and caches the value.
+static Handle<Value> LazyRowGetter(Local<String> property, const AccessorInfo& info) {
+	HandleScope scope;
+	auto holder = info.Holder();
+	const auto column_index = static_cast<uint32_t>(info.Data()->Int32Value());
+	
+	auto cache = holder->GetInternalField(LAZY_ROW_FIELD_CACHE);
+	if (cache->IsArray()) {
+		auto cached = Local<Array>::Cast(cache)->Get(column_index);
+		if (!cached->IsUndefined()) {
+			return scope.Close(cached);
+		}
+	}
+	
+	auto row = static_cast<const row_t*>(holder->GetPointerFromInternalField(LAZY_ROW_FIELD_ROW));
+	auto result_wrapper = node::ObjectWrap::Unwrap<ResultWrapper>(Local<Object>::Cast(holder->GetInternalField(LAZY_ROW_FIELD_RESULT)));
+	auto value = RecordValue(result_wrapper->result, row->records + column_index);
+	
+	if (!cache->IsArray()) {
+		cache = Array::New(static_cast<int>(row->length));
+		holder->SetInternalField(LAZY_ROW_FIELD_CACHE, cache);
+	}
+	Local<Array>::Cast(cache)->Set(column_index, value);
+	return scope.Close(value);
+}
+
+// Like ResultRows, but rows only point into the result, which is kept
+// alive by a ResultWrapper until every row is collected.
+static Local<Array> LazyResultRows(StatementWrapper *wrapper, result_t *result) {
+	const int column_count = column_count_sync(wrapper->statement);
+	auto result_object = ResultWrapper::NewInstance(result);
+	
+	auto rows = Array::New(static_cast<int>(result->length));
+	for (size_t i = 0; i < result->length; i++) {
+		auto object = wrapper->NewLazyRow(column_count, LazyRowGetter);
+		object->SetPointerInInternalField(LAZY_ROW_FIELD_ROW, result->rows + i);
+		object->SetInternalField(LAZY_ROW_FIELD_RESULT, result_object);
+		rows->Set(static_cast<uint32_t>(i), object);
+	}
+	return rows;
+}
+
+// Rows are reported both for a completed statement and for a batch that
+// stopped at its limits.
+static void QueryCallback(query_baton_t *baton) {
+	Local<Value> rows = Local<Value>::New(Null());
+	if ((baton->status == SQLITE_DONE || baton->status == SQLITE_ROW) && baton->result != NULL) {
+		auto wrapper = static_cast<StatementWrapper*>(baton->wrapper);
+		rows = baton->lazy ? LazyResultRows(wrapper, baton->result) : ResultRows(wrapper, baton->result);
+	}
+	
+	Local<Value> args[] = {
+		Local<Value>::New(Integer::New(baton->status)),
+		rows
+	};
+	
+	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	query_baton_free(baton);
+}
+
+static Handle<Value> All(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 5) {
+		ThrowException(Exception::TypeError(String::New("Expected at least five arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[4]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fifth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto baton = query_baton_new();
+	
+	baton->statement = statement_wrapper->statement;
+	baton->wrapper = statement_wrapper;
+	baton->c_callback = QueryCallback;
+	baton->js_callback = CachedCallbackArgument(args[4], statement_wrapper->result_callback, &baton->js_callback_owned);
+	baton->task.lane = LaneArgument(args, 1, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 2);
+	ResultFlagsArgument(args, 3, baton);
+	query_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+// Reports the first row, or with pluck only its first column, and
+// undefined when the statement returned no rows.
+static void GetCallback(query_baton_t *baton) {
+	auto wrapper = static_cast<StatementWrapper*>(baton->wrapper);
+	
+	// the job's copies replaced whatever was bound before it, unless a bind
+	// on the loop thread has changed the pins since it was scheduled
+	if (baton->params_bound > 0 && baton->binding_generation == wrapper->binding_generation) {
+		wrapper->ReleaseBindings(baton->params_bound);
+	}
+	
+	Local<Value> value = Local<Value>::New(Undefined());
+	if ((baton->status == SQLITE_DONE || baton->status == SQLITE_ROW) && baton->result != NULL && baton->result->length > 0) {
+		const row_t *row = baton->result->rows;
+		if (baton->pluck) {
+			value = row->length > 0 ? RecordValue(baton->result, row->records) : Local<Value>::New(Null());
+		} else {
+			auto object = wrapper->NewRow(static_cast<int>(row->length));
+			for (size_t i = 0; i < row->length; i++) {
+				object->Set(wrapper->ColumnName(static_cast<int>(i)), RecordValue(baton->result, row->records + i));
+			}
+			value = object;
+		}
+	}
+	
+	Local<Value> args[] = {
+		Local<Value>::New(Integer::New(baton->status == SQLITE_ROW ? SQLITE_DONE : baton->status)),
+		value
+	};
+	
+	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	query_baton_free(baton);
+}
+
+// Binds the array of parameters given as the second argument, if any, then
+// steps once, materializes the row and resets, all in one job. A truthy
+// fifth argument plucks the first column.
+static Handle<Value> Get(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 6) {
+		ThrowException(Exception::TypeError(String::New("Expected at least six arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[5]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Sixth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto baton = query_baton_new();
+	baton->statement = statement_wrapper->statement;
+	
+	if (args[1]->IsArray()) {
+		auto params = Local<Array>::Cast(args[1]);
+		baton->params = static_cast<record_t*>(calloc(params->Length(), sizeof(record_t)));
+		for (uint32_t i = 0; i < params->Length(); i++) {
+			if (!CopyParam(params->Get(i), baton->params + i)) {
+				query_baton_free(baton);
+				ThrowException(Exception::TypeError(String::New("Unsupported object type.")));
+				return scope.Close(Undefined());
+			}
+			baton->param_count++;
+		}
+	}
+	
+	baton->wrapper = statement_wrapper;
+	baton->binding_generation = statement_wrapper->binding_generation;
+	baton->c_callback = GetCallback;
+	baton->js_callback = CachedCallbackArgument(args[5], statement_wrapper->result_callback, &baton->js_callback_owned);
+	baton->max_rows = 1;
+	baton->single_row = 1;
+	baton->task.lane = LaneArgument(args, 2, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 3);
+	baton->pluck = args[4]->BooleanValue();
+	query_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+static Handle<Value> FetchBatch(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 7) {
+		ThrowException(Exception::TypeError(String::New("Expected at least seven arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsNumber() || !args[2]->IsNumber()) {
+	    ThrowException(Exception::TypeError(String::New("Batch limits must be numbers.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[6]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Seventh argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto baton = query_baton_new();
+	
+	baton->statement = statement_wrapper->statement;
+	baton->wrapper = statement_wrapper;
+	baton->c_callback = QueryCallback;
+	baton->js_callback = CallbackArgument(args, 6); // each stream reports batches to a function of its own
+	baton->js_callback_owned = 1;
+	baton->max_rows = static_cast<size_t>(args[1]->Uint32Value());
+	baton->max_bytes = static_cast<size_t>(args[2]->Uint32Value());
+	baton->task.lane = LaneArgument(args, 3, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 4);
+	ResultFlagsArgument(args, 5, baton);
+	query_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+static void FreePackedBatch(char *data, void *hint) {
+	free(data);
+}
+
+// The buffer adopts the encoded batch, and the column names are sent along
+// for the reader.
+static void PackedCallback(packed_baton_t *baton) {
+	Local<Value> batch = Local<Value>::New(Null());
+	Local<Value> names = Local<Value>::New(Null());
+	if (baton->status == SQLITE_DONE || baton->status == SQLITE_ROW) {
+		batch = Local<Value>::New(node::Buffer::New(baton->data, baton->length, FreePackedBatch, NULL)->handle_);
+		baton->data = NULL;
+		
+		const int column_count = column_count_sync(baton->statement);
+		auto array = Array::New(column_count);
+		for (int i = 0; i < column_count; i++) {
+			array->Set(static_cast<uint32_t>(i), String::NewSymbol(statement_column_name(baton->statement, i)));
+		}
+		names = array;
+	}
+	
+	Local<Value> args[] = {
+		Local<Value>::New(Integer::New(baton->status)),
+		batch,
+		names
+	};
+	
+	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
+	callback->Call(Context::GetCurrent()->Global(), 3, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	packed_baton_free(baton);
+}
+
+static Handle<Value> FetchPacked(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 6) {
+		ThrowException(Exception::TypeError(String::New("Expected at least six arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[1]->IsNumber() || !args[2]->IsNumber()) {
+	    ThrowException(Exception::TypeError(String::New("Batch limits must be numbers.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[5]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Sixth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto baton = packed_baton_new();
+	
+	baton->statement = statement_wrapper->statement;
+	baton->c_callback = PackedCallback;
+	baton->js_callback = CachedCallbackArgument(args[5], statement_wrapper->result_callback, &baton->js_callback_owned);
+	baton->max_rows = static_cast<size_t>(args[1]->Uint32Value());
+	baton->max_bytes = static_cast<size_t>(args[2]->Uint32Value());
+	baton->task.lane = LaneArgument(args, 3, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 4);
+	packed_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+// Creates a typed array through the global constructor and copies the
+// worker's buffer into its backing store. This V8 has no way to hand memory
+// it did not allocate to a typed array, so each column costs one memcpy on
+// the loop thread rather than being adopted as is.
+static Local<Object> TypedArray(const char *constructor_name, const void *data, size_t count, size_t element_size) {
+	auto constructor = Local<Function>::Cast(Context::GetCurrent()->Global()->Get(String::NewSymbol(constructor_name)));
+	Handle<Value> argv[] = {
+		Integer::NewFromUnsigned(static_cast<uint32_t>(count))
+	};
+	
+	auto array = constructor->NewInstance(1, argv);
+	if (count > 0) {
+		memcpy(array->GetIndexedPropertiesExternalArrayData(), data, count * element_size);
+	}
+	return array;
+}
+
+static Local<Object> ColumnObject(statement_t *statement, const column_set_t *set, int index) {
+	static const char *kind_names[] = { "null", "number", "text", "blob" };
+	const column_t *column = set->columns + index;
+	
+	auto object = Object::New();
+	object->Set(String::NewSymbol("name"), String::New(statement_column_name(statement, index)));
+	object->Set(String::NewSymbol("type"), String::NewSymbol(kind_names[column->kind]));
+	object->Set(String::NewSymbol("nulls"), TypedArray("Uint8Array", column->nulls, (set->length + 7) / 8, sizeof(uint8_t)));
+	
+	switch (column->kind) {
+		case column_kind_number:
+			object->Set(String::NewSymbol("values"), TypedArray("Float64Array", column->numbers, set->length, sizeof(double)));
+			object->Set(String::NewSymbol("lossy"), Boolean::New(column->lossy != 0));
+			break;
+		case column_kind_text:
+		case column_kind_blob:
+			object->Set(String::NewSymbol("offsets"), TypedArray("Uint32Array", column->offsets, set->length + 1, sizeof(uint32_t)));
+			object->Set(String::NewSymbol("data"), TypedArray("Uint8Array", column->text, column->text_length, sizeof(char)));
+			break;
+		default:
+			break;
+	}
+	return object;
+}
+
+static void ColumnsCallback(columnar_baton_t *baton) {
+	Local<Value> columns = Local<Value>::New(Null());
+	if (baton->status == SQLITE_DONE && baton->columns != NULL) {
+		auto array = Array::New(baton->columns->column_count);
+		for (int i = 0; i < baton->columns->column_count; i++) {
+			array->Set(static_cast<uint32_t>(i), ColumnObject(baton->statement, baton->columns, i));
+		}
+		columns = array;
+	}
+	
+	Local<Value> args[] = {
+		Local<Value>::New(Integer::New(baton->status)),
+		columns,
+		Local<Value>::New(Number::New(baton->columns != NULL ? static_cast<double>(baton->columns->length) : 0))
+	};
+	
+	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
+	callback->Call(Context::GetCurrent()->Global(), 3, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	columnar_baton_free(baton);
+}
+
+static Handle<Value> Columns(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 4) {
+		ThrowException(Exception::TypeError(String::New("Expected at least four arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First argument must be an object.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[3]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Fourth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	auto baton = columnar_baton_new();
+	
+	baton->statement = statement_wrapper->statement;
+	baton->c_callback = ColumnsCallback;
+	baton->js_callback = CachedCallbackArgument(args[3], statement_wrapper->result_callback, &baton->js_callback_owned);
+	baton->task.lane = LaneArgument(args, 1, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 2);
+	columnar_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+// Maps a typed array onto the element type the worker writes, or returns
+// false for arrays it cannot fill.
+static bool FillType(Handle<Object> array, fill_type_t *type) {
+	if (!array->HasIndexedPropertiesInExternalArrayData()) {
+		return false;
+	}
+	
+	switch (array->GetIndexedPropertiesExternalArrayDataType()) {
+		case kExternalDoubleArray:
+			*type = fill_type_double;
+			return true;
+		case kExternalFloatArray:
+			*type = fill_type_float;
+			return true;
+		case kExternalIntArray:
+			*type = fill_type_int32;
+			return true;
+		case kExternalUnsignedIntArray:
+			*type = fill_type_uint32;
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void FillCallback(fill_baton_t *baton) {
+	Local<Value> args[] = {
+		Local<Value>::New(Integer::New(baton->status)),
+		Local<Value>::New(Number::New(static_cast<double>(baton->rows)))
+	};
+	
+	// the callback may start the next fill
+	static_cast<StatementWrapper*>(baton->wrapper)->filling = false;
+	
+	Persistent<Function> callback = static_cast<Function*>(baton->js_callback);
+	callback->Call(Context::GetCurrent()->Global(), 2, args);
+	if (baton->js_callback_owned) {
+		callback.Dispose();
+	}
+	fill_baton_free(baton);
+}
+
+// Targets are keyed by column name. The arrays' backing stores are written
+// by the worker directly, so no values are allocated on the heap. The
+// target list and the pins on the arrays belong to the statement, which only
+// runs one fill at a time, and the callback handle is cached like the step
+// one, so polling with the same arrays and callback allocates nothing.
+static Handle<Value> FillInto(const Arguments& args) {
+	HandleScope scope;
+	
+	if (args.Length() < 6) {
+		ThrowException(Exception::TypeError(String::New("Expected at least six arguments.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[0]->IsObject() || !args[1]->IsObject()) {
+	    ThrowException(Exception::TypeError(String::New("First two arguments must be objects.")));
+	    return scope.Close(Undefined());
+	}
+	
+	if (!args[2]->IsNumber()) {
+	    ThrowException(Exception::TypeError(String::New("Row limit must be a number.")));
+	    return scope.Close(Undefined());
+	}
+    
+	if (!args[5]->IsFunction()) {
+	    ThrowException(Exception::TypeError(String::New("Sixth argument must be a function.")));
+	    return scope.Close(Undefined());
+	}
+	
+	auto statement_wrapper = node::ObjectWrap::Unwrap<StatementWrapper>(Handle<Object>::Cast(args[0]));
+	if (statement_wrapper->filling) {
+		ThrowException(Exception::Error(String::New("A fill is already in progress on this statement.")));
+		return scope.Close(Undefined());
+	}
+	
+	auto targets = Handle<Object>::Cast(args[1]);
+	const int column_count = column_count_sync(statement_wrapper->statement);
+	auto& fill_targets = statement_wrapper->fill_targets;
+	if (fill_targets.capacity() < static_cast<size_t>(column_count)) {
+		fill_targets.reserve(column_count);
+		async_allocation_count++;
+	}
+	
+	fill_targets.clear();
+	size_t max_rows = static_cast<size_t>(args[2]->Uint32Value());
+	for (int i = 0; i < column_count; i++) {
+		auto target = targets->Get(String::NewSymbol(statement_column_name(statement_wrapper->statement, i)));
+		if (target->IsUndefined()) {
+			continue;
+		}
+		
+		fill_type_t type;
+		if (!target->IsObject() || !FillType(Handle<Object>::Cast(target), &type)) {
+			ThrowException(Exception::TypeError(String::New("Fill targets must be Float64Array, Float32Array, Int32Array or Uint32Array.")));
+			return scope.Close(Undefined());
+		}
+		
+		auto array = Handle<Object>::Cast(target);
+		const size_t length = static_cast<size_t>(array->GetIndexedPropertiesExternalArrayDataLength());
+		if (length < max_rows) {
+			max_rows = length;
+		}
+		
+		fill_target_t fill_target;
+		fill_target.column_index = i;
+		fill_target.type = type;
+		fill_target.data = array->GetIndexedPropertiesExternalArrayData();
+		statement_wrapper->PinFillTarget(fill_targets.size(), array);
+		fill_targets.push_back(fill_target);
+	}
+	
+	if (fill_targets.empty()) {
+		ThrowException(Exception::Error(String::New("No fill target matches a result column.")));
+		return scope.Close(Undefined());
+	}
+	statement_wrapper->UnpinFillTargets(fill_targets.size());
+	
+	auto baton = fill_baton_new();
+	
+	baton->statement = statement_wrapper->statement;
+	baton->wrapper = statement_wrapper;
+	baton->c_callback = FillCallback;
+	baton->js_callback = CachedCallbackArgument(args[5], statement_wrapper->fill_callback, &baton->js_callback_owned);
+	baton->targets = fill_targets.data();
+	baton->target_count = static_cast<int>(fill_targets.size());
+	baton->max_rows = max_rows;
+	baton->task.lane = LaneArgument(args, 3, statement_wrapper->statement->lane);
+	baton->task.deadline = DeadlineArgument(args, 4);
+	statement_wrapper->filling = true;
+	fill_schedule(baton);
+	
+	return scope.Close(Undefined());
+}
+
+static inline void AddFunction(Handle<Object> exports, const char *name, Handle<Value> (&function)(const Arguments&)) {
+	exports->Set(String::NewSymbol(name), FunctionTemplate::New(function)->GetFunction());
+}
+
+static void ExportTypes(Handle<Object> exports) {
+	DbWrapper::Init(exports);
+	ResultWrapper::Init(exports);
+	StatementWrapper::Init(exports);
+}
+
+static void ExportFunctions(Handle<Object> exports) {
+	AddFunction(exports, "all", All);
+	AddFunction(exports, "allocationCount", AllocationCount);
+	AddFunction(exports, "bind", Bind);
+	AddFunction(exports, "cancel", Cancel);
+	AddFunction(exports, "changes", Changes);
+	AddFunction(exports, "clearBindings", ClearBindings);
+	AddFunction(exports, "close", Close);
+	AddFunction(exports, "columnBlob", ColumnBlob);
+	AddFunction(exports, "columnCount", ColumnCount);
+	AddFunction(exports, "columnFloat", ColumnFloat);
+	AddFunction(exports, "columnInteger", ColumnInteger);
+	AddFunction(exports, "columnText", ColumnText);
+    AddFunction(exports, "columnType", ColumnType);
+	AddFunction(exports, "columnValue", ColumnValue);
+	AddFunction(exports, "columns", Columns);
+	AddFunction(exports, "errMsg", ErrMsg);
+	AddFunction(exports, "fetchBatch", FetchBatch);
+	AddFunction(exports, "fetchPacked", FetchPacked);
+	AddFunction(exports, "fillInto", FillInto);
+	AddFunction(exports, "finalize", Finalize);
+	AddFunction(exports, "get", Get);
+	AddFunction(exports, "getAutocommit", GetAutocommit);
+	AddFunction(exports, "inlineStepThreshold", InlineStepThreshold);
+	AddFunction(exports, "lastInsertRowId", LastInsertRowId);
+	AddFunction(exports, "open", Open);
+	AddFunction(exports, "poolSize", PoolSize);
+	AddFunction(exports, "prepare", Prepare);
+	AddFunction(exports, "prepareSync", PrepareSync);
+	AddFunction(exports, "queueDepths", QueueDepths);
+	AddFunction(exports, "reset", Reset);
+	AddFunction(exports, "row", Row);
+	AddFunction(exports, "runSync", RunSync);
+	AddFunction(exports, "setInlineStepThreshold", SetInlineStepThreshold);
+	AddFunction(exports, "setPoolSize", SetPoolSize);
+	AddFunction(exports, "sql", Sql);
+    AddFunction(exports, "step", Step);
+	AddFunction(exports, "stepN", StepN);
+	AddFunction(exports, "stepStats", StepStats);
+	AddFunction(exports, "stepSync", StepSync);
+	AddFunction(exports, "version", Version);
+}
+
+static void DrainCompletions(void) {
+	HandleScope scope;
+	completion_run();
 }
 
 static void Init(Handle<Object> exports) {
+	completion_init(uv_default_loop(), DrainCompletions);
 	ExportTypes(exports);
 	ExportFunctions(exports);
 }
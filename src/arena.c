@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 8
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk_t))
+
+void arena_init(arena_t *arena) {
+	arena->chunks = NULL;
+	arena->cursor = NULL;
+	arena->remaining = 0;
+}
+
+static char *arena_add_chunk(arena_t *arena, size_t chunk_size) {
+	arena_chunk_t *chunk = malloc(chunk_size);
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	return (char*)chunk + ARENA_HEADER_SIZE;
+}
+
+// Allocations too large for a chunk get one of their own, leaving the
+// current chunk to be filled by later allocations.
+void *arena_alloc(arena_t *arena, size_t size) {
+	size = ARENA_ALIGN(size);
+	
+	if (size > ARENA_CHUNK_SIZE - ARENA_HEADER_SIZE) {
+		return arena_add_chunk(arena, size + ARENA_HEADER_SIZE);
+	}
+	
+	if (size > arena->remaining) {
+		arena->cursor = arena_add_chunk(arena, ARENA_CHUNK_SIZE);
+		arena->remaining = ARENA_CHUNK_SIZE - ARENA_HEADER_SIZE;
+	}
+	
+	void *allocation = arena->cursor;
+	arena->cursor += size;
+	arena->remaining -= size;
+	return allocation;
+}
+
+void arena_release(arena_t *arena) {
+	arena_chunk_t *chunk = arena->chunks;
+	while (chunk != NULL) {
+		arena_chunk_t *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	arena_init(arena);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef __BS_ARENA_H__
+#define __BS_ARENA_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//
+// Bump allocator over a list of large chunks. Individual allocations are
+// never freed; the whole arena is released at once.
+//
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct arena_chunk_t {
+	struct arena_chunk_t *next;
+} arena_chunk_t;
+
+typedef struct arena_t {
+	arena_chunk_t *chunks;
+	char *cursor;
+	size_t remaining;
+} arena_t;
+
+void arena_init(arena_t *arena);
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_release(arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_ARENA_H__ */
\ No newline at end of file
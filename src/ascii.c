@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include <string.h>
+#include "ascii.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HIGH_BITS_64 0x8080808080808080ULL
+
+static int text_is_ascii_scalar(const unsigned char *restrict text, size_t length) {
+	uint64_t high_bits = 0;
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8) {
+		uint64_t word;
+		memcpy(&word, text + i, sizeof(word));
+		high_bits |= word;
+	}
+	
+	for (; i < length; i++) {
+		high_bits |= text[i];
+	}
+	return (high_bits & HIGH_BITS_64) == 0;
+}
+
+int text_is_ascii(const char *text, size_t length) {
+	const unsigned char *bytes = (const unsigned char *)text;
+	size_t i = 0;
+	
+#if defined(__AVX2__)
+	__m256i high_bits = _mm256_setzero_si256();
+	for (; i + 32 <= length; i += 32) {
+		high_bits = _mm256_or_si256(high_bits, _mm256_loadu_si256((const __m256i *)(bytes + i)));
+	}
+	if (_mm256_movemask_epi8(high_bits) != 0) {
+		return 0;
+	}
+#elif defined(__SSE2__)
+	__m128i high_bits = _mm_setzero_si128();
+	for (; i + 16 <= length; i += 16) {
+		high_bits = _mm_or_si128(high_bits, _mm_loadu_si128((const __m128i *)(bytes + i)));
+	}
+	if (_mm_movemask_epi8(high_bits) != 0) {
+		return 0;
+	}
+#endif
+	
+	return text_is_ascii_scalar(bytes + i, length - i);
+}
\ No newline at end of file
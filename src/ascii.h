@@ -0,0 +1,20 @@
+#ifndef __BS_ASCII_H__
+#define __BS_ASCII_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Returns non-zero when no byte of the text has its high bit set. Uses AVX2
+// or SSE2 when the compiler targets them, and eight bytes at a time
+// otherwise.
+int text_is_ascii(const char *text, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_ASCII_H__ */
\ No newline at end of file
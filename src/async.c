@@ -0,0 +1,3 @@
+#include "async.h"
+
+unsigned long async_allocation_count = 0;
\ No newline at end of file
@@ -1,46 +1,94 @@
 #ifndef __BS_ASYNC_H__
 #define __BS_ASYNC_H__
 
+#include <stdlib.h>
+#include <string.h>
 #include <uv.h>
+#include "completion.h"
+#include "db.h"
+#include "pool.h"
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 	
+// Number of batons that had to be allocated because nothing could be
+// recycled, plus every persistent handle created for a callback or to pin a
+// Buffer or typed array. Only ever touched on the loop thread.
+extern unsigned long async_allocation_count;
+
+// Batons are created and released on the loop thread only, so released ones
+// are kept on a plain per-type free list, linked through their task.
+//
+// name##_inline runs the operation right away on the loop thread, but its
+// callback is still delivered through the completion queue on a later tick.
+// name##_hold accounts for the operation like name##_async but leaves
+// submitting its task to the caller, for operations that have to wait for
+// others to finish first.
 #define ASYNC(name) \
+static task_t *name##_free_list = NULL; \
+\
 name##_baton_t *name##_baton_new(void) { \
+	task_t *task = name##_free_list; \
+	if (task != NULL) { \
+		name##_baton_t *baton = (name##_baton_t*)task->data; \
+		name##_free_list = task->next; \
+		memset(baton, 0, sizeof(name##_baton_t)); \
+		return baton; \
+	} \
+	async_allocation_count++; \
 	return calloc(1, sizeof(name##_baton_t)); \
 } \
 \
 void name##_baton_free(name##_baton_t *baton) { \
 	name##_baton_free_members(baton); \
-	uv_close((uv_handle_t*)&baton->async, NULL); \
-	free(baton); \
+	baton->task.data = baton; \
+	baton->task.next = name##_free_list; \
+	name##_free_list = &baton->task; \
 } \
 \
-static void name##_async_begin(void *arg) { \
-	name##_baton_t *baton = (name##_baton_t*)arg; \
+static void name##_async_begin(task_t *task) { \
+	name##_baton_t *baton = (name##_baton_t*)task->data; \
 	name##_baton_do(baton); \
-	uv_async_send(&baton->async); \
+	task_finish(task); \
+	completion_push(task); \
 } \
 \
-static void name##_async_end(uv_async_t *handle, int status) { \
-	name##_baton_t* baton = (name##_baton_t*)handle->data; \
+static void name##_async_end(task_t *task) { \
+	name##_baton_t* baton = (name##_baton_t*)task->data; \
+	name##_baton_db(baton)->pending--; \
 	baton->c_callback(baton); \
 } \
 \
+static void name##_async_prepare(name##_baton_t *baton) { \
+	baton->task.run = name##_async_begin; \
+	baton->task.complete = name##_async_end; \
+	baton->task.data = baton; \
+	completion_begin(); \
+	name##_baton_db(baton)->pending++; \
+} \
+\
 void name##_async(name##_baton_t *baton) { \
-	uv_thread_t thread_id; \
-	uv_async_init(uv_default_loop(), &baton->async, name##_async_end); \
-	baton->async.data = baton; \
-	uv_thread_create(&thread_id, name##_async_begin, baton); \
+	name##_async_prepare(baton); \
+	db_submit(name##_baton_db(baton), &baton->task); \
+} \
+\
+void name##_inline(name##_baton_t *baton) { \
+	name##_async_prepare(baton); \
+	name##_async_begin(&baton->task); \
+} \
+\
+void name##_hold(name##_baton_t *baton) { \
+	name##_async_prepare(baton); \
 }
 
 #define ASYNC_HEADER(name) \
 name##_baton_t *name##_baton_new(void); \
 void name##_baton_free(name##_baton_t *baton); \
-void name##_async(name##_baton_t *baton);
+void name##_async(name##_baton_t *baton); \
+void name##_inline(name##_baton_t *baton); \
+void name##_hold(name##_baton_t *baton);
 
 #ifdef __cplusplus
 }
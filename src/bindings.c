@@ -21,6 +21,12 @@ int bind_text_sync(statement_t *stmt, int index, const char *value, int length)
 	return sqlite3_bind_text(stmt->sqlite_statement, index, value, length, free);
 }
 
+// The caller keeps the memory alive until the parameter is rebound or the
+// statement is finalized.
+int bind_blob_sync(statement_t *stmt, int index, const void *value, int length) {
+	return sqlite3_bind_blob(stmt->sqlite_statement, index, value, length, SQLITE_STATIC);
+}
+
 int bind_null_sync(statement_t *stmt, int index) {
 	return sqlite3_bind_null(stmt->sqlite_statement, index);
 }
@@ -45,6 +51,16 @@ const char *column_text_sync(statement_t *stmt, int column_index) {
 	return (const char *)sqlite3_column_text(stmt->sqlite_statement, column_index);
 }
 
+const void *column_blob_sync(statement_t *stmt, int column_index) {
+	return sqlite3_column_blob(stmt->sqlite_statement, column_index);
+}
+
+// Must be called after column_text_sync or column_blob_sync, which may
+// convert the value.
+int column_bytes_sync(statement_t *stmt, int column_index) {
+	return sqlite3_column_bytes(stmt->sqlite_statement, column_index);
+}
+
 int reset_sync(statement_t *stmt) {
 	return sqlite3_reset(stmt->sqlite_statement);
 }
@@ -72,16 +88,69 @@ const char *errmsg_sync(db_t *db) {
 const char *libversion_sync(void) {
 	return sqlite3_libversion();
 }
+// Operations still in flight would run on a finalized statement, so they
+// have to complete first.
 int finalize_sync(statement_t *stmt) {
+	if (stmt->task_count > 0) {
+		return SQLITE_MISUSE;
+	}
 	return sqlite3_finalize(stmt->sqlite_statement);
 }
 
+int prepare_sync(db_t *db, statement_t *stmt, const char *sql, int sql_length) {
+	if (db_busy(db)) {
+		return SQLITE_MISUSE;
+	}
+	const int result = sqlite3_prepare_v2(db->sqlite_db, sql, sql_length, &stmt->sqlite_statement, NULL);
+	if (result == SQLITE_OK) {
+		statement_capture_plan(stmt);
+	}
+	return result;
+}
+
+// Stepping on the loop thread would interleave rows with the statement's
+// operations in flight, or reset it under the worker running one, whatever
+// the kind of connection.
+static int statement_in_use(statement_t *stmt) {
+	return db_busy(stmt->db) || stmt->task_count > 0;
+}
+
+int step_sync(statement_t *stmt) {
+	if (statement_in_use(stmt)) {
+		return SQLITE_MISUSE;
+	}
+	return sqlite3_step(stmt->sqlite_statement);
+}
+
+int run_sync(statement_t *stmt) {
+	if (statement_in_use(stmt)) {
+		return SQLITE_MISUSE;
+	}
+	
+	int result;
+	while ((result = sqlite3_step(stmt->sqlite_statement)) == SQLITE_ROW);
+	sqlite3_reset(stmt->sqlite_statement);
+	return result;
+}
+
 //
 // open
 // ----
 
 static void open_baton_do(open_baton_t *restrict baton) {
-	baton->result = sqlite3_open(baton->filename, &baton->db->sqlite_db);
+	int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+	if (baton->db->worker != NULL) {
+		// every call on this connection is serialized by its own thread
+		flags |= SQLITE_OPEN_NOMUTEX;
+	}
+	baton->result = sqlite3_open_v2(baton->filename, &baton->db->sqlite_db, flags, NULL);
+	if (baton->result == SQLITE_OK) {
+		db_watch_progress(baton->db);
+	}
+}
+
+static db_t *open_baton_db(open_baton_t *restrict baton) {
+	return baton->db;
 }
 
 static void open_baton_free_members(open_baton_t *restrict baton) {
@@ -100,6 +169,10 @@ static void close_baton_do(close_baton_t *restrict baton) {
 	baton->result = sqlite3_close_v2(baton->db->sqlite_db);
 }
 
+static db_t *close_baton_db(close_baton_t *restrict baton) {
+	return baton->db;
+}
+
 static void close_baton_free_members(close_baton_t *restrict baton) {
 }
 
@@ -117,6 +190,14 @@ static void prepare_baton_do(prepare_baton_t *restrict baton) {
 		&baton->statement->sqlite_statement,
 		NULL
 	);
+	
+	if (baton->result == SQLITE_OK) {
+		statement_capture_plan(baton->statement);
+	}
+}
+
+static db_t *prepare_baton_db(prepare_baton_t *restrict baton) {
+	return baton->db;
 }
 
 static void prepare_baton_free_members(prepare_baton_t *restrict baton) {
@@ -131,12 +212,46 @@ ASYNC(prepare);
 // step
 // ----
 
+// Steps up to `limit` times, stopping early at the first result that is not
+// a row. `rows` is the number of rows the statement advanced over. A step
+// that was cancelled or timed out before it started is not run at all.
 static void step_baton_do(step_baton_t *restrict baton) {
-	baton->result = sqlite3_step(baton->statement->sqlite_statement);
+	if (task_expired(&baton->task)) {
+		baton->result = SQLITE_INTERRUPT;
+		return;
+	}
+	
+	db_begin_task(baton->statement->db, &baton->task);
+	do {
+		const uint64_t start = uv_hrtime();
+		baton->result = sqlite3_step(baton->statement->sqlite_statement);
+		statement_record_step(baton->statement, uv_hrtime() - start);
+	} while (baton->result == SQLITE_ROW && ++baton->rows < baton->limit);
+	db_end_task(baton->statement->db);
+}
+
+static db_t *step_baton_db(step_baton_t *restrict baton) {
+	return baton->statement->db;
 }
 
 static void step_baton_free_members(step_baton_t *restrict baton) {
+	statement_untrack(baton->statement, &baton->task);
 }
 
 ASYNC(step);
 
+// Runs cheap steps right on the loop thread, as long as nothing else is in
+// flight on the connection that could make the step wait for its mutex.
+void step_schedule(step_baton_t *baton) {
+	statement_t *statement = baton->statement;
+	if (!statement_track(statement, &baton->task)) {
+		statement->offloaded_steps++;
+		step_hold(baton);
+	} else if (statement->db->pending == 0 && statement_prefers_inline(statement, baton->limit)) {
+		statement->inline_steps++;
+		step_inline(baton);
+	} else {
+		statement->offloaded_steps++;
+		step_async(baton);
+	}
+}
\ No newline at end of file
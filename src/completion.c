@@ -0,0 +1,46 @@
+#include <stddef.h>
+#include "completion.h"
+#include "queue.h"
+
+static uv_async_t async;
+static queue_t queue;
+static void (*drain_callback)(void) = NULL;
+static unsigned int in_flight = 0;
+
+static void completion_async(uv_async_t *handle, int status) {
+	drain_callback();
+}
+
+void completion_init(uv_loop_t *loop, void (*drain)(void)) {
+	queue_init(&queue);
+	drain_callback = drain;
+	uv_async_init(loop, &async, completion_async);
+	
+	// only keep the loop alive while there is work in flight
+	uv_unref((uv_handle_t*)&async);
+}
+
+// Called on the loop thread for every task before it is submitted.
+void completion_begin(void) {
+	if (in_flight++ == 0) {
+		uv_ref((uv_handle_t*)&async);
+	}
+}
+
+// Called on a worker thread once a task has finished running.
+void completion_push(task_t *task) {
+	queue_push(&queue, task);
+	uv_async_send(&async);
+}
+
+// Runs the completion callback of every finished task. A task that is still
+// being linked in by its worker is picked up by the wakeup that worker sends.
+void completion_run(void) {
+	task_t *task;
+	while ((task = queue_pop(&queue)) != NULL) {
+		if (--in_flight == 0) {
+			uv_unref((uv_handle_t*)&async);
+		}
+		task->complete(task);
+	}
+}
\ No newline at end of file
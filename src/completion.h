@@ -0,0 +1,27 @@
+#ifndef __BS_COMPLETION_H__
+#define __BS_COMPLETION_H__
+
+#include <uv.h>
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//
+// Finished tasks are handed back to the loop thread through one shared
+// queue. A single async handle wakes the loop, and the drain function
+// passed to completion_init then runs every pending completion in one go.
+//
+
+void completion_init(uv_loop_t *loop, void (*drain)(void));
+void completion_begin(void);
+void completion_push(task_t *task);
+void completion_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_COMPLETION_H__ */
\ No newline at end of file
@@ -1,10 +1,63 @@
 #include <stdlib.h>
 #include "db.h"
 
-db_t *db_new(void) {
-	return calloc(1, sizeof(db_t));
+db_t *db_new(int dedicated_thread) {
+	db_t *db = calloc(1, sizeof(db_t));
+	if (dedicated_thread) {
+		db->worker = worker_new();
+	}
+	return db;
+}
+
+void db_submit(db_t *db, task_t *task) {
+	if (db->worker != NULL) {
+		worker_submit(db->worker, task);
+	} else {
+		pool_submit(task);
+	}
+}
+
+// A connection opened without its own mutex must not be used from the loop
+// thread while its worker may still be running an operation for it.
+int db_busy(db_t *db) {
+	return db->worker != NULL && db->pending > 0;
+}
+
+// Number of virtual machine instructions between two deadline checks.
+#define PROGRESS_INTERVAL 1000
+
+static int db_progress(void *arg) {
+	db_t *db = (db_t*)arg;
+	return db->running != NULL && task_expired(db->running);
+}
+
+// Lets a running task be interrupted once it has been cancelled or has run
+// past its deadline, in which case SQLite fails it with SQLITE_INTERRUPT.
+void db_watch_progress(db_t *db) {
+	sqlite3_progress_handler(db->sqlite_db, PROGRESS_INTERVAL, db_progress, db);
+}
+
+// Holds the connection mutex for the whole task so that the progress
+// handler always sees the task it is actually running. SQLite's connection
+// mutex is recursive, and absent when the connection has its own thread.
+void db_begin_task(db_t *db, task_t *task) {
+	sqlite3_mutex_enter(sqlite3_db_mutex(db->sqlite_db));
+	db->running = task;
+}
+
+void db_end_task(db_t *db) {
+	db->running = NULL;
+	sqlite3_mutex_leave(sqlite3_db_mutex(db->sqlite_db));
+}
+
+void db_stop_worker(db_t *db) {
+	if (db->worker != NULL) {
+		worker_free(db->worker);
+		db->worker = NULL;
+	}
 }
 
 void db_free(db_t *db) {
+	db_stop_worker(db);
 	free(db);
 }
\ No newline at end of file
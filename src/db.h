@@ -1,6 +1,8 @@
 #ifndef __BS_DB_H__
 #define __BS_DB_H__
 
+#include "pool.h"
+#include "worker.h"
 #include "sqlite3/sqlite3.h"
 
 #ifdef __cplusplus
@@ -10,9 +12,18 @@ extern "C"
 
 typedef struct db_t {
 	sqlite3 *sqlite_db;
+	worker_t *worker;
+	unsigned int pending;
+	task_t *running;
 } db_t;
 
-db_t *db_new(void);
+db_t *db_new(int dedicated_thread);
+void db_submit(db_t *db, task_t *task);
+int db_busy(db_t *db);
+void db_watch_progress(db_t *db);
+void db_begin_task(db_t *db, task_t *task);
+void db_end_task(db_t *db);
+void db_stop_worker(db_t *db);
 void db_free(db_t *db);
 
 #ifdef __cplusplus
@@ -7,6 +7,8 @@
 class DbWrapper final : public node::ObjectWrap {
 public:
 	db_t *db;
+	using node::ObjectWrap::Ref; // held by operations that report the wrapper back
+	using node::ObjectWrap::Unref;
 	static void Init(v8::Handle<v8::Object> exports);
 
 private:
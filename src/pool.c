@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include "pool.h"
+
+//
+// A fixed set of long-lived worker threads fed from one FIFO queue per
+// priority lane. Tasks are only ever submitted from the loop thread, so
+// starting the threads lazily on the first submission needs no extra
+// synchronization.
+//
+
+typedef struct lane_t {
+	task_t *head;
+	task_t *tail;
+	unsigned int depth;
+} lane_t;
+
+static unsigned int size = POOL_DEFAULT_SIZE;
+static int started = 0;
+static uv_thread_t threads[POOL_MAX_SIZE];
+static uv_mutex_t mutex;
+static uv_cond_t cond;
+static lane_t lanes[pool_lane_count];
+static unsigned int interactive_streak = 0;
+
+// May be called from any thread while the task is queued or running.
+void task_cancel(task_t *task) {
+	__atomic_store_n(&task->cancelled, 1, __ATOMIC_RELEASE);
+}
+
+// True once the task has been cancelled or its deadline (an uv_hrtime
+// timestamp, zero for none) has passed.
+int task_expired(task_t *task) {
+	return __atomic_load_n(&task->cancelled, __ATOMIC_ACQUIRE)
+		|| (task->deadline != 0 && uv_hrtime() >= task->deadline);
+}
+
+void task_finish(task_t *task) {
+	__atomic_store_n(&task->finished, 1, __ATOMIC_RELEASE);
+}
+
+int task_finished(task_t *task) {
+	return __atomic_load_n(&task->finished, __ATOMIC_ACQUIRE);
+}
+
+unsigned int pool_size(void) {
+	return size;
+}
+
+int pool_set_size(unsigned int new_size) {
+	if (started || new_size < 1 || new_size > POOL_MAX_SIZE) {
+		return -1;
+	}
+	
+	size = new_size;
+	return 0;
+}
+
+unsigned int pool_queue_depth(pool_lane_t lane) {
+	if (!started) {
+		return 0;
+	}
+	
+	uv_mutex_lock(&mutex);
+	const unsigned int depth = lanes[lane].depth;
+	uv_mutex_unlock(&mutex);
+	return depth;
+}
+
+// Must be called with the mutex held and at least one task queued.
+static pool_lane_t pool_next_lane(void) {
+	const int has_interactive = lanes[pool_lane_interactive].head != NULL;
+	const int has_background = lanes[pool_lane_background].head != NULL;
+	
+	if (has_interactive && (!has_background || interactive_streak < POOL_BACKGROUND_INTERVAL)) {
+		interactive_streak++;
+		return pool_lane_interactive;
+	}
+	
+	interactive_streak = 0;
+	return pool_lane_background;
+}
+
+static task_t *pool_take(void) {
+	uv_mutex_lock(&mutex);
+	while (lanes[pool_lane_interactive].head == NULL && lanes[pool_lane_background].head == NULL) {
+		uv_cond_wait(&cond, &mutex);
+	}
+	
+	lane_t *lane = lanes + pool_next_lane();
+	task_t *task = lane->head;
+	lane->head = task->next;
+	if (lane->head == NULL) {
+		lane->tail = NULL;
+	}
+	lane->depth--;
+	uv_mutex_unlock(&mutex);
+	
+	task->next = NULL;
+	return task;
+}
+
+static void pool_worker(void *arg) {
+	for (;;) {
+		task_t *task = pool_take();
+		task->run(task);
+	}
+}
+
+static void pool_start(void) {
+	uv_mutex_init(&mutex);
+	uv_cond_init(&cond);
+	for (unsigned int i = 0; i < size; i++) {
+		uv_thread_create(threads + i, pool_worker, NULL);
+	}
+	started = 1;
+}
+
+void pool_submit(task_t *task) {
+	if (!started) {
+		pool_start();
+	}
+	
+	lane_t *lane = lanes + (task->lane == pool_lane_background ? pool_lane_background : pool_lane_interactive);
+	task->next = NULL;
+	uv_mutex_lock(&mutex);
+	if (lane->tail == NULL) {
+		lane->head = task;
+	} else {
+		lane->tail->next = task;
+	}
+	lane->tail = task;
+	lane->depth++;
+	uv_cond_signal(&cond);
+	uv_mutex_unlock(&mutex);
+}
+
+// Takes a task back out of its lane if no worker has picked it up yet.
+// Returns 1 if the task was removed, 0 if it is running or already done.
+int pool_cancel(task_t *task) {
+	if (!started) {
+		return 0;
+	}
+	
+	lane_t *lane = lanes + (task->lane == pool_lane_background ? pool_lane_background : pool_lane_interactive);
+	int removed = 0;
+	
+	uv_mutex_lock(&mutex);
+	task_t *prev = NULL;
+	for (task_t *current = lane->head; current != NULL; prev = current, current = current->next) {
+		if (current == task) {
+			if (prev == NULL) {
+				lane->head = task->next;
+			} else {
+				prev->next = task->next;
+			}
+			if (lane->tail == task) {
+				lane->tail = prev;
+			}
+			lane->depth--;
+			removed = 1;
+			break;
+		}
+	}
+	uv_mutex_unlock(&mutex);
+	
+	if (removed) {
+		task->next = NULL;
+	}
+	return removed;
+}
\ No newline at end of file
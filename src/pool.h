@@ -0,0 +1,51 @@
+#ifndef __BS_POOL_H__
+#define __BS_POOL_H__
+
+#include <stdint.h>
+#include <uv.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define POOL_DEFAULT_SIZE 4
+#define POOL_MAX_SIZE 128
+
+// After this many interactive tasks in a row, a waiting background task is
+// taken next so that the background lane can never starve.
+#define POOL_BACKGROUND_INTERVAL 4
+
+typedef enum pool_lane_t {
+	pool_lane_interactive = 0,
+	pool_lane_background = 1,
+	pool_lane_count = 2
+} pool_lane_t;
+
+typedef struct task_t {
+	struct task_t *next;
+	void (*run)(struct task_t *);
+	void (*complete)(struct task_t *);
+	void *data;
+	pool_lane_t lane;
+	uint64_t deadline;
+	int cancelled;
+	int finished; // set once run, before the completion is queued
+} task_t;
+
+void task_cancel(task_t *task);
+int task_expired(task_t *task);
+void task_finish(task_t *task);
+int task_finished(task_t *task);
+
+unsigned int pool_size(void);
+int pool_set_size(unsigned int size);
+void pool_submit(task_t *task);
+int pool_cancel(task_t *task);
+unsigned int pool_queue_depth(pool_lane_t lane);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_POOL_H__ */
\ No newline at end of file
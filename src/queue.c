@@ -0,0 +1,49 @@
+#include <stddef.h>
+#include "queue.h"
+
+void queue_init(queue_t *queue) {
+	queue->stub.next = NULL;
+	queue->head = &queue->stub;
+	queue->tail = &queue->stub;
+}
+
+void queue_push(queue_t *queue, task_t *task) {
+	__atomic_store_n(&task->next, NULL, __ATOMIC_RELAXED);
+	task_t *prev = __atomic_exchange_n(&queue->head, task, __ATOMIC_ACQ_REL);
+	__atomic_store_n(&prev->next, task, __ATOMIC_RELEASE);
+}
+
+// Returns NULL when the queue is empty, and also while a producer has
+// swapped the head but not yet linked its task, in which case the caller
+// should retry.
+task_t *queue_pop(queue_t *queue) {
+	task_t *tail = queue->tail;
+	task_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	
+	if (tail == &queue->stub) {
+		if (next == NULL) {
+			return NULL;
+		}
+		queue->tail = next;
+		tail = next;
+		next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	}
+	
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+	
+	if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+	
+	queue_push(queue, &queue->stub);
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if (next != NULL) {
+		queue->tail = next;
+		return tail;
+	}
+	
+	return NULL;
+}
\ No newline at end of file
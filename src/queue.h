@@ -0,0 +1,31 @@
+#ifndef __BS_QUEUE_H__
+#define __BS_QUEUE_H__
+
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//
+// Intrusive multi-producer, single-consumer queue of tasks. Pushing is
+// wait-free and may happen from any thread; popping must only ever happen
+// from one consumer thread at a time.
+//
+
+typedef struct queue_t {
+	task_t *head;
+	task_t *tail;
+	task_t stub;
+} queue_t;
+
+void queue_init(queue_t *queue);
+void queue_push(queue_t *queue, task_t *task);
+task_t *queue_pop(queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_QUEUE_H__ */
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "result_wrapper.h"
+
+using namespace v8;
+
+static const char *const className = "ResultWrapper";
+
+Persistent<Function> ResultWrapper::constructor;
+
+ResultWrapper::ResultWrapper() : result(NULL) {
+}
+
+ResultWrapper::~ResultWrapper() {
+	if (result != NULL) {
+		result_release(result);
+		result = NULL;
+	}
+}
+
+void ResultWrapper::Init(Handle<Object> exports) {
+	// Prepare constructor template
+	auto tpl = FunctionTemplate::New(New);
+	tpl->SetClassName(String::NewSymbol(className));
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	// Prototype
+	constructor = Persistent<Function>::New(tpl->GetFunction());
+	exports->Set(String::NewSymbol(className), constructor);
+}
+
+Local<Object> ResultWrapper::NewInstance(result_t *result) {
+	HandleScope scope;
+	auto instance = constructor->NewInstance();
+	auto wrapper = node::ObjectWrap::Unwrap<ResultWrapper>(instance);
+	result_retain(result);
+	wrapper->result = result;
+	return scope.Close(instance);
+}
+
+Handle<Value> ResultWrapper::New(const Arguments& args) {
+	HandleScope scope;
+
+	if (args.IsConstructCall()) {
+		ResultWrapper *obj = new ResultWrapper();
+		obj->Wrap(args.This());
+		return args.This();
+	} else {
+		return scope.Close(constructor->NewInstance());
+	}
+}
\ No newline at end of file
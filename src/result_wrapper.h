@@ -0,0 +1,22 @@
+#ifndef __BS_RESULT_WRAPPER_H__
+#define __BS_RESULT_WRAPPER_H__
+
+#include <node.h>
+#include "results.h"
+
+// Holds a reference on a materialized result for as long as lazy rows
+// reading from it are reachable.
+class ResultWrapper final : public node::ObjectWrap {
+public:
+	result_t *result;
+	static void Init(v8::Handle<v8::Object> exports);
+	static v8::Local<v8::Object> NewInstance(result_t *result);
+
+private:
+	ResultWrapper();
+	~ResultWrapper();
+	static v8::Handle<v8::Value> New(const v8::Arguments& args);
+	static v8::Persistent<v8::Function> constructor;
+};
+
+#endif /* __BS_RESULT_WRAPPER_H__ */
\ No newline at end of file
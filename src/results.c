@@ -1,48 +1,46 @@
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include "ascii.h"
 #include "results.h"
 #include "sqlite3/sqlite3.h"
 
-static void record_free_members(record_t *record) {
-	switch (record->type) {
-		case record_type_text:
-			free(record->value.text_value.text);
-			break;
-		case record_type_blob:
-			free(record->value.blob_value.data);
-			break;
-		default:
-			break; // no members to free
-	}
-}
+#define RESULT_INITIAL_CAPACITY 64
+#define INTERN_INITIAL_SLOTS 64
 
-static void row_free_members(row_t *row) {
-	for (size_t i = 0; i < row->length; i++) {
-		record_free_members(row->records + i);
-	}
-	free(row->records);
+static void intern_table_init(intern_table_t *restrict table, uint32_t slot_count) {
+	table->count = 0;
+	table->slot_count = slot_count;
+	table->slots = slot_count > 0 ? calloc(slot_count, sizeof(uint32_t)) : NULL;
+	table->values = slot_count > 0 ? malloc(slot_count / 2 * sizeof(intern_value_t)) : NULL;
 }
 
-result_t *result_new(size_t length, row_t *restrict rows) {
+result_t *result_new(int intern) {
 	result_t *result = malloc(sizeof(result_t));
-	result->length = length;
-	
-	const size_t row_array_size = length * sizeof(row_t);
-	result->rows = malloc(row_array_size);
-	memcpy(result->rows, rows, row_array_size);
-	
+	result->length = 0;
+	result->capacity = RESULT_INITIAL_CAPACITY;
+	result->rows = malloc(result->capacity * sizeof(row_t));
+	arena_init(&result->arena);
+	intern_table_init(&result->interns, intern ? INTERN_INITIAL_SLOTS : 0);
+	result->refs = 1;
 	return result;
 }
 
-static void result_free_members(result_t *result) {
-	for (size_t i = 0; i < result->length; i++) {
-		row_free_members(result->rows + i);
-	}
-	free(result->rows);
+void result_retain(result_t *result) {
+	result->refs++;
 }
 
-void result_free(result_t *result) {
-	result_free_members(result);
+// Records and their values all live in the arena, so only the chunks and
+// the row array need freeing.
+void result_release(result_t *result) {
+	if (--result->refs > 0) {
+		return;
+	}
+	
+	arena_release(&result->arena);
+	free(result->interns.slots);
+	free(result->interns.values);
+	free(result->rows);
 	free(result);
 }
 
@@ -50,20 +48,112 @@ void result_free(result_t *result) {
 // query
 // -----
 
-static char* copy_string(const char* restrict src, size_t *restrict out_length) {
-	const size_t str_length = strlen(src);
-	const size_t mem_length = str_length + 1;
-	char *dst = malloc(mem_length);
-	memcpy(dst, src, mem_length);
+static char *query_copy_text(const unsigned char *src, size_t length, arena_t *restrict arena) {
+	char *dst = arena_alloc(arena, length + 1);
+	memcpy(dst, src, length);
+	dst[length] = '\0';
+	return dst;
+}
+
+// FNV-1a
+static uint32_t intern_hash(const unsigned char *text, size_t length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ text[i]) * 16777619u;
+	}
+	return hash;
+}
+
+// Returns the slot holding the value, or the empty slot where it belongs.
+// The table is kept at most half full, so probing always ends.
+static uint32_t *intern_slot(intern_table_t *restrict table, const unsigned char *text, size_t length, uint32_t hash) {
+	const uint32_t mask = table->slot_count - 1;
+	for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+		uint32_t *slot = table->slots + i;
+		if (*slot == 0) {
+			return slot;
+		}
+		
+		const intern_value_t *value = table->values + (*slot - 1);
+		if (value->hash == hash && value->length == length && memcmp(value->text, text, length) == 0) {
+			return slot;
+		}
+	}
+}
+
+static void intern_table_grow(intern_table_t *restrict table) {
+	free(table->slots);
+	table->slot_count *= 2;
+	table->slots = calloc(table->slot_count, sizeof(uint32_t));
+	table->values = realloc(table->values, table->slot_count / 2 * sizeof(intern_value_t));
 	
-	if (out_length != NULL) {
-		*out_length = str_length;
+	for (uint32_t i = 0; i < table->count; i++) {
+		const intern_value_t *value = table->values + i;
+		*intern_slot(table, (const unsigned char *)value->text, value->length, value->hash) = i + 1;
 	}
+}
+
+// Returns the number of bytes copied into the arena, which is zero when the
+// text was already interned.
+static size_t query_read_text(sqlite3_stmt *stmt, int column_index, result_t *restrict result, record_t *restrict record) {
+	const unsigned char *src = sqlite3_column_text(stmt, column_index);
+	const size_t length = (size_t)sqlite3_column_bytes(stmt, column_index);
+	intern_table_t *table = &result->interns;
+	
+	record->type = record_type_text;
+	record->value.text_value.length = length;
+	record->value.text_value.intern = 0;
 	
+	uint32_t hash = 0;
+	uint32_t *slot = NULL;
+	if (table->slot_count > 0 && length <= INTERN_MAX_LENGTH) {
+		hash = intern_hash(src, length);
+		slot = intern_slot(table, src, length, hash);
+		if (*slot != 0) {
+			const intern_value_t *value = table->values + (*slot - 1);
+			record->value.text_value.text = (char *)value->text;
+			record->value.text_value.ascii = value->ascii;
+			record->value.text_value.intern = *slot;
+			return 0;
+		}
+	}
+	
+	record->value.text_value.text = query_copy_text(src, length, &result->arena);
+	record->value.text_value.ascii = length >= EXTERNAL_TEXT_MIN_LENGTH && text_is_ascii(record->value.text_value.text, length);
+	
+	if (slot != NULL && table->count < INTERN_MAX_VALUES) {
+		table->values[table->count] = (intern_value_t){
+			.text = record->value.text_value.text,
+			.length = length,
+			.hash = hash,
+			.ascii = record->value.text_value.ascii
+		};
+		*slot = ++table->count;
+		record->value.text_value.intern = table->count;
+		
+		if (table->count < INTERN_MAX_VALUES && table->count * 2 >= table->slot_count) {
+			intern_table_grow(table);
+		}
+	}
+	return length + 1;
+}
+
+static void *query_copy_blob(sqlite3_stmt *stmt, int column_index, arena_t *restrict arena, size_t *restrict out_length) {
+	const void *src = sqlite3_column_blob(stmt, column_index);
+	const size_t length = (size_t)sqlite3_column_bytes(stmt, column_index);
+	if (length == 0) {
+		*out_length = 0;
+		return NULL;
+	}
+	
+	void *dst = arena_alloc(arena, length);
+	memcpy(dst, src, length);
+	*out_length = length;
 	return dst;
 }
 
-static void query_read_record(sqlite3_stmt *stmt, int column_index, record_t *restrict record) {
+// Returns the number of bytes copied out of line for the record.
+static size_t query_read_record(sqlite3_stmt *stmt, int column_index, result_t *restrict result, record_t *restrict record) {
 	switch(sqlite3_column_type(stmt, column_index)) {
 		case SQLITE_INTEGER:
 			record->type = record_type_integer;
@@ -74,52 +164,559 @@ static void query_read_record(sqlite3_stmt *stmt, int column_index, record_t *re
 			record->value.float_value = sqlite3_column_double(stmt, column_index);
 			break;
 		case SQLITE_TEXT:
-			record->type = record_type_text;
-			record->value.text_value.text = copy_string((const char*)sqlite3_column_text(stmt, column_index),
-				&record->value.text_value.length);
-			break;
+			return query_read_text(stmt, column_index, result, record);
+		case SQLITE_BLOB:
+			record->type = record_type_blob;
+			record->value.blob_value.data = query_copy_blob(stmt, column_index, &result->arena,
+				&record->value.blob_value.length);
+			return record->value.blob_value.length;
 		case SQLITE_NULL:
 		default: // return null for unsupported types
 			record->type = record_type_null;
 			break;
 	}
+	return 0;
 }
 
-static void query_read_row(sqlite3_stmt *stmt, row_t *restrict row) {
+// Returns the number of bytes the row occupies in the arena.
+static size_t query_read_row(sqlite3_stmt *stmt, result_t *restrict result, row_t *restrict row) {
 	const int record_count = sqlite3_column_count(stmt);
-	record_t *records = malloc(record_count * sizeof(record_t));
+	size_t size = record_count * sizeof(record_t);
+	record_t *records = arena_alloc(&result->arena, size);
 	for (int i = 0; i < record_count; i++) {
-		query_read_record(stmt, i, records + i);
+		size += query_read_record(stmt, i, result, records + i);
 	}
 	
 	row->length = record_count;
 	row->records = records;
+	return size;
 }
 
-static result_t *query_get_result(sqlite3_stmt *stmt) {
-	int step_result;
-	unsigned int row_count = 0;
-	unsigned int row_capacity = 64;
-	row_t *rows = malloc(row_capacity * sizeof(row_t));
+// Steps until the statement is done or a limit is reached, in which case the
+// status is SQLITE_ROW. Limits of zero are unbounded; the byte limit is
+// checked after each row, so a batch always makes progress.
+static result_t *query_get_result(sqlite3_stmt *stmt, size_t max_rows, size_t max_bytes, int intern, int *restrict out_status) {
+	int step_result = SQLITE_ROW;
+	size_t bytes = 0;
+	result_t *result = result_new(intern);
 	
-	while ((step_result = sqlite3_step(stmt)) == SQLITE_ROW) {
-		if (row_count == row_capacity) {
-			row_capacity *= 2;
-			rows = realloc(rows, row_capacity);
+	while ((max_rows == 0 || result->length < max_rows) && (max_bytes == 0 || bytes < max_bytes)) {
+		if ((step_result = sqlite3_step(stmt)) != SQLITE_ROW) {
+			break;
+		}
+		
+		if (result->length == result->capacity) {
+			result->capacity *= 2;
+			result->rows = realloc(result->rows, result->capacity * sizeof(row_t));
 		}
-		query_read_row(stmt, rows + (row_count++));
+		bytes += query_read_row(stmt, result, result->rows + (result->length++));
 	}
 	
-	result_t *result = result_new(row_count, rows);
-	free(rows);
+	*out_status = step_result;
 	return result; 
 }
 
+// Binds the baton's copies of the parameters. Text and blobs are handed over
+// to sqlite, which frees them once they are rebound, so the baton no longer
+// owns them.
+static int query_bind_params(sqlite3_stmt *stmt, query_baton_t *restrict baton) {
+	for (int i = 0; i < baton->param_count; i++) {
+		record_t *param = baton->params + i;
+		int result;
+		switch (param->type) {
+			case record_type_integer:
+				result = sqlite3_bind_int64(stmt, i + 1, param->value.integer_value);
+				break;
+			case record_type_float:
+				result = sqlite3_bind_double(stmt, i + 1, param->value.float_value);
+				break;
+			case record_type_text:
+				result = sqlite3_bind_text(stmt, i + 1, param->value.text_value.text,
+					(int)param->value.text_value.length, free);
+				param->value.text_value.text = NULL;
+				break;
+			case record_type_blob:
+				result = sqlite3_bind_blob(stmt, i + 1, param->value.blob_value.data,
+					(int)param->value.blob_value.length, free);
+				param->value.blob_value.data = NULL;
+				break;
+			case record_type_null:
+			default:
+				result = sqlite3_bind_null(stmt, i + 1);
+				break;
+		}
+		
+		if (result != SQLITE_OK) {
+			return result;
+		}
+		baton->params_bound = i + 1;
+	}
+	return SQLITE_OK;
+}
+
+static void query_free_params(query_baton_t *restrict baton) {
+	for (int i = 0; i < baton->param_count; i++) {
+		record_t *param = baton->params + i;
+		if (param->type == record_type_text) {
+			free(param->value.text_value.text);
+		} else if (param->type == record_type_blob) {
+			free(param->value.blob_value.data);
+		}
+	}
+	free(baton->params);
+}
+
+// Steps the statement up to the baton's limits. Once it has run to
+// completion or failed, or a single row was asked for, it is reset so that
+// it can be run again with the same bindings. Parameters are bound here
+// rather than on the loop thread, where they would change the bindings of
+// operations queued ahead of this one.
 static void query_baton_do(query_baton_t *restrict baton) {
-	baton->result = query_get_result(baton->statement->sqlite_statement);
+	if (task_expired(&baton->task)) {
+		baton->status = SQLITE_INTERRUPT;
+		return;
+	}
+	
+	sqlite3_stmt *stmt = baton->statement->sqlite_statement;
+	db_begin_task(baton->statement->db, &baton->task);
+	
+	const int bind_result = baton->params != NULL ? query_bind_params(stmt, baton) : SQLITE_OK;
+	if (bind_result != SQLITE_OK) {
+		baton->status = bind_result;
+	} else {
+		baton->result = query_get_result(stmt, baton->max_rows, baton->max_bytes, baton->intern, &baton->status);
+		if (baton->status != SQLITE_ROW || baton->single_row) {
+			sqlite3_reset(stmt);
+		}
+	}
+	db_end_task(baton->statement->db);
+}
+
+static db_t *query_baton_db(query_baton_t *restrict baton) {
+	return baton->statement->db;
 }
 
 static void query_baton_free_members(query_baton_t *restrict baton) {
+	if (baton->result != NULL) {
+		result_release(baton->result);
+	}
+	if (baton->params != NULL) {
+		query_free_params(baton);
+	}
+	
+	statement_untrack(baton->statement, &baton->task);
+}
+
+ASYNC(query);
+
+void query_schedule(query_baton_t *baton) {
+	if (statement_track(baton->statement, &baton->task)) {
+		query_async(baton);
+	} else {
+		query_hold(baton);
+	}
+}
+
+//
+// columnar
+// --------
+
+#define COLUMN_INITIAL_CAPACITY 64 // rows, kept a multiple of 8 for the null bitmap
+#define COLUMN_INITIAL_TEXT_CAPACITY 256
+
+static void column_set_kind(column_t *restrict column, column_kind_t kind, size_t capacity);
+
+// Only TEXT affinity tells what a column holds: sqlite converts whatever is
+// stored there to text. Columns of the other affinities keep text that does
+// not look like a number, as dates often are, so they are decided by their
+// first value.
+static column_kind_t column_kind_of(column_affinity_t affinity) {
+	return affinity == column_affinity_text ? column_kind_text : column_kind_null;
+}
+
+static column_set_t *column_set_new(statement_t *statement) {
+	const int column_count = sqlite3_column_count(statement->sqlite_statement);
+	column_set_t *set = malloc(sizeof(column_set_t));
+	set->length = 0;
+	set->capacity = COLUMN_INITIAL_CAPACITY;
+	set->column_count = column_count;
+	set->columns = calloc(column_count, sizeof(column_t));
+	for (int i = 0; i < column_count; i++) {
+		set->columns[i].nulls = calloc(set->capacity / 8, 1);
+		
+		const column_kind_t kind = column_kind_of(statement_column_affinity(statement, i));
+		if (kind != column_kind_null) {
+			column_set_kind(set->columns + i, kind, set->capacity);
+		}
+	}
+	
+	return set;
+}
+
+void column_set_free(column_set_t *set) {
+	for (int i = 0; i < set->column_count; i++) {
+		column_t *column = set->columns + i;
+		free(column->numbers);
+		free(column->offsets);
+		free(column->text);
+		free(column->nulls);
+	}
+	free(set->columns);
+	free(set);
+}
+
+static void column_set_grow(column_set_t *restrict set) {
+	const size_t capacity = set->capacity * 2;
+	for (int i = 0; i < set->column_count; i++) {
+		column_t *column = set->columns + i;
+		column->nulls = realloc(column->nulls, capacity / 8);
+		memset(column->nulls + set->capacity / 8, 0, (capacity - set->capacity) / 8);
+		
+		if (column->numbers != NULL) {
+			column->numbers = realloc(column->numbers, capacity * sizeof(double));
+		}
+		if (column->offsets != NULL) {
+			column->offsets = realloc(column->offsets, (capacity + 1) * sizeof(uint32_t));
+		}
+	}
+	set->capacity = capacity;
+}
+
+// Rows read before the first non-null value are all null, so zeroed storage
+// already describes them. Blob columns share the text storage.
+static void column_set_kind(column_t *restrict column, column_kind_t kind, size_t capacity) {
+	column->kind = kind;
+	if (kind == column_kind_number) {
+		column->numbers = calloc(capacity, sizeof(double));
+	} else {
+		column->offsets = calloc(capacity + 1, sizeof(uint32_t));
+		column->text_capacity = COLUMN_INITIAL_TEXT_CAPACITY;
+		column->text = malloc(column->text_capacity);
+	}
+}
+
+static void column_append_text(column_t *restrict column, const unsigned char *text, size_t length) {
+	if (column->text_length + length > column->text_capacity) {
+		while (column->text_length + length > column->text_capacity) {
+			column->text_capacity *= 2;
+		}
+		column->text = realloc(column->text, column->text_capacity);
+	}
+	memcpy(column->text + column->text_length, text, length);
+	column->text_length += length;
+}
+
+// Doubles hold integers exactly up to 2^53.
+#define COLUMN_EXACT_INTEGER_LIMIT 9007199254740992LL
+
+static column_kind_t column_kind_of_value(int type) {
+	switch (type) {
+		case SQLITE_TEXT:
+			return column_kind_text;
+		case SQLITE_BLOB:
+			return column_kind_blob;
+		default:
+			return column_kind_number;
+	}
+}
+
+static void column_read_value(sqlite3_stmt *stmt, int index, column_t *restrict column, size_t row, size_t capacity) {
+	const int type = sqlite3_column_type(stmt, index);
+	const int is_null = type == SQLITE_NULL;
+	
+	if (is_null) {
+		column->nulls[row / 8] |= (uint8_t)(1 << (row % 8));
+	} else if (column->kind == column_kind_null) {
+		column_set_kind(column, column_kind_of_value(type), capacity);
+	}
+	
+	switch (column->kind) {
+		case column_kind_number:
+			if (type == SQLITE_INTEGER) {
+				const sqlite3_int64 value = sqlite3_column_int64(stmt, index);
+				if (value > COLUMN_EXACT_INTEGER_LIMIT || value < -COLUMN_EXACT_INTEGER_LIMIT) {
+					column->lossy = 1;
+				}
+				column->numbers[row] = (double)value;
+			} else {
+				column->numbers[row] = is_null ? 0.0 : sqlite3_column_double(stmt, index);
+			}
+			break;
+		case column_kind_text:
+			if (!is_null) {
+				const unsigned char *text = sqlite3_column_text(stmt, index);
+				column_append_text(column, text, (size_t)sqlite3_column_bytes(stmt, index));
+			}
+			column->offsets[row + 1] = (uint32_t)column->text_length;
+			break;
+		case column_kind_blob:
+			if (!is_null) {
+				const void *blob = sqlite3_column_blob(stmt, index);
+				column_append_text(column, blob, (size_t)sqlite3_column_bytes(stmt, index));
+			}
+			column->offsets[row + 1] = (uint32_t)column->text_length;
+			break;
+		default:
+			break; // nothing stored until the kind is known
+	}
+}
+
+static void column_set_read_row(sqlite3_stmt *stmt, column_set_t *restrict set) {
+	if (set->length == set->capacity) {
+		column_set_grow(set);
+	}
+	
+	for (int i = 0; i < set->column_count; i++) {
+		column_read_value(stmt, i, set->columns + i, set->length, set->capacity);
+	}
+	set->length++;
 }
 
-ASYNC(query);
\ No newline at end of file
+static void columnar_baton_do(columnar_baton_t *restrict baton) {
+	if (task_expired(&baton->task)) {
+		baton->status = SQLITE_INTERRUPT;
+		return;
+	}
+	
+	sqlite3_stmt *stmt = baton->statement->sqlite_statement;
+	db_begin_task(baton->statement->db, &baton->task);
+	
+	column_set_t *set = column_set_new(baton->statement);
+	int step_result;
+	while ((step_result = sqlite3_step(stmt)) == SQLITE_ROW) {
+		column_set_read_row(stmt, set);
+	}
+	
+	baton->status = step_result;
+	baton->columns = set;
+	sqlite3_reset(stmt);
+	db_end_task(baton->statement->db);
+}
+
+static db_t *columnar_baton_db(columnar_baton_t *restrict baton) {
+	return baton->statement->db;
+}
+
+static void columnar_baton_free_members(columnar_baton_t *restrict baton) {
+	if (baton->columns != NULL) {
+		column_set_free(baton->columns);
+	}
+	
+	statement_untrack(baton->statement, &baton->task);
+}
+
+ASYNC(columnar);
+
+void columnar_schedule(columnar_baton_t *baton) {
+	if (statement_track(baton->statement, &baton->task)) {
+		columnar_async(baton);
+	} else {
+		columnar_hold(baton);
+	}
+}
+
+//
+// packed
+// ------
+
+#define PACKED_INITIAL_CAPACITY 4096
+
+static char *packed_reserve(packed_baton_t *restrict baton, size_t size) {
+	if (baton->length + size > baton->capacity) {
+		while (baton->length + size > baton->capacity) {
+			baton->capacity *= 2;
+		}
+		baton->data = realloc(baton->data, baton->capacity);
+	}
+	
+	char *dst = baton->data + baton->length;
+	baton->length += size;
+	return dst;
+}
+
+static void packed_store_u32(char *dst, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		dst[i] = (char)(value >> (8 * i));
+	}
+}
+
+static void packed_store_u64(char *dst, uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		dst[i] = (char)(value >> (8 * i));
+	}
+}
+
+static void packed_write_bytes(packed_baton_t *restrict baton, const void *bytes, size_t length) {
+	char *dst = packed_reserve(baton, PACKED_LENGTH_SIZE + length);
+	packed_store_u32(dst, (uint32_t)length);
+	if (length > 0) {
+		memcpy(dst + PACKED_LENGTH_SIZE, bytes, length);
+	}
+}
+
+static void packed_write_cell(sqlite3_stmt *stmt, int column_index, packed_baton_t *restrict baton) {
+	const int type = sqlite3_column_type(stmt, column_index);
+	switch (type) {
+		case SQLITE_INTEGER: {
+			char *dst = packed_reserve(baton, PACKED_TAG_SIZE + PACKED_NUMBER_SIZE);
+			dst[0] = (char)record_type_integer;
+			packed_store_u64(dst + PACKED_TAG_SIZE, (uint64_t)sqlite3_column_int64(stmt, column_index));
+			break;
+		}
+		case SQLITE_FLOAT: {
+			const double value = sqlite3_column_double(stmt, column_index);
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			
+			char *dst = packed_reserve(baton, PACKED_TAG_SIZE + PACKED_NUMBER_SIZE);
+			dst[0] = (char)record_type_float;
+			packed_store_u64(dst + PACKED_TAG_SIZE, bits);
+			break;
+		}
+		case SQLITE_TEXT: {
+			const unsigned char *text = sqlite3_column_text(stmt, column_index);
+			*packed_reserve(baton, PACKED_TAG_SIZE) = (char)record_type_text;
+			packed_write_bytes(baton, text, (size_t)sqlite3_column_bytes(stmt, column_index));
+			break;
+		}
+		case SQLITE_BLOB: {
+			const void *blob = sqlite3_column_blob(stmt, column_index);
+			*packed_reserve(baton, PACKED_TAG_SIZE) = (char)record_type_blob;
+			packed_write_bytes(baton, blob, (size_t)sqlite3_column_bytes(stmt, column_index));
+			break;
+		}
+		case SQLITE_NULL:
+		default:
+			*packed_reserve(baton, PACKED_TAG_SIZE) = (char)record_type_null;
+			break;
+	}
+}
+
+// Same limits as query_get_result, with the byte limit applying to the
+// encoded batch.
+static void packed_baton_do(packed_baton_t *restrict baton) {
+	if (task_expired(&baton->task)) {
+		baton->status = SQLITE_INTERRUPT;
+		return;
+	}
+	
+	sqlite3_stmt *stmt = baton->statement->sqlite_statement;
+	db_begin_task(baton->statement->db, &baton->task);
+	
+	const int column_count = sqlite3_column_count(stmt);
+	uint32_t row_count = 0;
+	baton->capacity = PACKED_INITIAL_CAPACITY;
+	baton->data = malloc(baton->capacity);
+	baton->length = PACKED_HEADER_SIZE;
+	
+	int step_result = SQLITE_ROW;
+	while ((baton->max_rows == 0 || row_count < baton->max_rows) &&
+		(baton->max_bytes == 0 || baton->length < baton->max_bytes)) {
+		if ((step_result = sqlite3_step(stmt)) != SQLITE_ROW) {
+			break;
+		}
+		
+		for (int i = 0; i < column_count; i++) {
+			packed_write_cell(stmt, i, baton);
+		}
+		row_count++;
+	}
+	
+	packed_store_u32(baton->data, row_count);
+	packed_store_u32(baton->data + 4, (uint32_t)column_count);
+	baton->status = step_result;
+	if (step_result != SQLITE_ROW) {
+		sqlite3_reset(stmt);
+	}
+	db_end_task(baton->statement->db);
+}
+
+static db_t *packed_baton_db(packed_baton_t *restrict baton) {
+	return baton->statement->db;
+}
+
+static void packed_baton_free_members(packed_baton_t *restrict baton) {
+	free(baton->data);
+	
+	statement_untrack(baton->statement, &baton->task);
+}
+
+ASYNC(packed);
+
+void packed_schedule(packed_baton_t *baton) {
+	if (statement_track(baton->statement, &baton->task)) {
+		packed_async(baton);
+	} else {
+		packed_hold(baton);
+	}
+}
+
+//
+// fill
+// ----
+
+static void fill_write(sqlite3_stmt *stmt, const fill_target_t *restrict target, size_t row) {
+	const int is_null = sqlite3_column_type(stmt, target->column_index) == SQLITE_NULL;
+	switch (target->type) {
+		case fill_type_double:
+			((double *)target->data)[row] = is_null ? NAN : sqlite3_column_double(stmt, target->column_index);
+			break;
+		case fill_type_float:
+			((float *)target->data)[row] = is_null ? NAN : (float)sqlite3_column_double(stmt, target->column_index);
+			break;
+		case fill_type_int32:
+			((int32_t *)target->data)[row] = (int32_t)sqlite3_column_int64(stmt, target->column_index);
+			break;
+		case fill_type_uint32:
+			((uint32_t *)target->data)[row] = (uint32_t)sqlite3_column_int64(stmt, target->column_index);
+			break;
+	}
+}
+
+// Same status and reset rules as query_baton_do, with max_rows bounded by
+// the shortest target.
+static void fill_baton_do(fill_baton_t *restrict baton) {
+	if (task_expired(&baton->task)) {
+		baton->status = SQLITE_INTERRUPT;
+		return;
+	}
+	
+	sqlite3_stmt *stmt = baton->statement->sqlite_statement;
+	db_begin_task(baton->statement->db, &baton->task);
+	
+	int step_result = SQLITE_ROW;
+	while (baton->rows < baton->max_rows) {
+		if ((step_result = sqlite3_step(stmt)) != SQLITE_ROW) {
+			break;
+		}
+		
+		for (int i = 0; i < baton->target_count; i++) {
+			fill_write(stmt, baton->targets + i, baton->rows);
+		}
+		baton->rows++;
+	}
+	
+	baton->status = step_result;
+	if (step_result != SQLITE_ROW) {
+		sqlite3_reset(stmt);
+	}
+	db_end_task(baton->statement->db);
+}
+
+static db_t *fill_baton_db(fill_baton_t *restrict baton) {
+	return baton->statement->db;
+}
+
+static void fill_baton_free_members(fill_baton_t *restrict baton) {
+	statement_untrack(baton->statement, &baton->task);
+}
+
+ASYNC(fill);
+
+void fill_schedule(fill_baton_t *baton) {
+	if (statement_track(baton->statement, &baton->task)) {
+		fill_async(baton);
+	} else {
+		fill_hold(baton);
+	}
+}
\ No newline at end of file
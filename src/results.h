@@ -2,7 +2,9 @@
 #define __BS_RESULTS_H__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <uv.h>
+#include "arena.h"
 #include "async.h"
 #include "sqlite3/sqlite3.h"
 #include "statement.h"
@@ -28,6 +30,8 @@ typedef struct record_t {
 		struct {
 			size_t length;
 			char *text;
+			int ascii; // tagged on the worker from EXTERNAL_TEXT_MIN_LENGTH bytes
+			uint32_t intern; // index + 1 in the result's intern table, or zero
 		} text_value;
 		struct {
 			size_t length;
@@ -41,24 +45,176 @@ typedef struct row_t {
 	record_t *records;
 } row_t;
 
+// Text at least this long is tagged ASCII on the worker when it is, and then
+// handed to V8 as an external one-byte string instead of being copied. V8
+// only supports external one-byte strings for ASCII, and has no one-byte
+// constructor, so shorter text is decoded as UTF-8 whatever it holds and is
+// not scanned.
+#define EXTERNAL_TEXT_MIN_LENGTH 1024
+
+// Distinct short text values of a result, collected on the worker so that
+// the loop thread makes one string per value. Values past the limit are
+// simply not interned.
+#define INTERN_MAX_LENGTH 64
+#define INTERN_MAX_VALUES 4096
+
+typedef struct intern_value_t {
+	const char *text;
+	size_t length;
+	uint32_t hash;
+	int ascii;
+} intern_value_t;
+
+typedef struct intern_table_t {
+	uint32_t count;
+	uint32_t slot_count; // a power of two, or zero when interning is off
+	uint32_t *slots; // index + 1 in values, zero for an empty slot
+	intern_value_t *values;
+} intern_table_t;
+
+// Results are reference counted so that strings handed to V8 can keep the
+// arena they point into alive. References are only taken and released on
+// the loop thread once the worker is done with the result.
 typedef struct result_t {
 	size_t length;
+	size_t capacity;
 	row_t *rows;
+	arena_t arena;
+	intern_table_t interns;
+	unsigned int refs;
 } result_t;
 
-result_t *result_new(size_t length, row_t *restrict rows);
-void result_free(result_t *result);
+result_t *result_new(int intern);
+void result_retain(result_t *result);
+void result_release(result_t *result);
 
 typedef struct query_baton_t {
-	uv_work_t req;
+	task_t task;
 	statement_t *statement;
-	uv_async_t async;
 	void (*c_callback)(struct query_baton_t *);
 	void *js_callback;
+	int js_callback_owned;
+	void *wrapper; // the StatementWrapper, which owns the row template
+	size_t max_rows; // zero for no limit
+	size_t max_bytes;
+	int lazy; // rows are reported as accessors over the result
+	int single_row; // reset after the first row, for get and pluck
+	int pluck; // only the first column of the first row is reported
+	int intern; // repeated short text values share one string
+	record_t *params; // bound on the worker before stepping, NULL to keep the bindings
+	int param_count;
+	int params_bound; // leading params bound so far, replacing the earlier values
+	unsigned int binding_generation; // the wrapper's, when the job was scheduled
+	int status;
 	result_t *result;
 } query_baton_t;
 
 ASYNC_HEADER(query)
+void query_schedule(query_baton_t *baton);
+
+// Columnar results keep one contiguous array per column instead of one
+// record per value. A column declared with TEXT affinity is a text column,
+// any other takes its kind from its first non-null value. Values are
+// converted to the kind the way sqlite3_column_* would.
+typedef enum column_kind_t {
+	column_kind_null = 0,
+	column_kind_number,
+	column_kind_text,
+	column_kind_blob
+} column_kind_t;
+
+typedef struct column_t {
+	column_kind_t kind;
+	int lossy; // an integer did not fit a double exactly
+	double *numbers;
+	uint32_t *offsets; // text or blob row i spans offsets[i] to offsets[i + 1]
+	char *text;
+	size_t text_length;
+	size_t text_capacity;
+	uint8_t *nulls; // one bit per row, set when the value is null
+} column_t;
+
+typedef struct column_set_t {
+	size_t length;
+	size_t capacity;
+	int column_count;
+	column_t *columns;
+} column_set_t;
+
+void column_set_free(column_set_t *set);
+
+typedef struct columnar_baton_t {
+	task_t task;
+	statement_t *statement;
+	void (*c_callback)(struct columnar_baton_t *);
+	void *js_callback;
+	int js_callback_owned;
+	int status;
+	column_set_t *columns;
+} columnar_baton_t;
+
+ASYNC_HEADER(columnar)
+void columnar_schedule(columnar_baton_t *baton);
+
+// Packed batches serialize rows into one buffer: a header of two uint32s,
+// the row and column counts, then for every cell a record_type_t byte
+// followed by an int64 or double, or a uint32 length and that many bytes
+// for text and blobs. Nulls have no payload. Everything is little-endian.
+// lib/packed_reader.js mirrors these sizes.
+#define PACKED_HEADER_SIZE 8
+#define PACKED_TAG_SIZE 1
+#define PACKED_NUMBER_SIZE 8
+#define PACKED_LENGTH_SIZE 4
+
+typedef struct packed_baton_t {
+	task_t task;
+	statement_t *statement;
+	void (*c_callback)(struct packed_baton_t *);
+	void *js_callback;
+	int js_callback_owned;
+	size_t max_rows; // zero for no limit
+	size_t max_bytes;
+	int status;
+	char *data; // handed over to the callback, which clears it
+	size_t length;
+	size_t capacity;
+} packed_baton_t;
+
+ASYNC_HEADER(packed)
+void packed_schedule(packed_baton_t *baton);
+
+// Fills caller-provided typed arrays with numeric columns, one element per
+// row. Nulls are written as NaN to floating point arrays and 0 to integer
+// ones.
+typedef enum fill_type_t {
+	fill_type_double = 0,
+	fill_type_float,
+	fill_type_int32,
+	fill_type_uint32
+} fill_type_t;
+
+typedef struct fill_target_t {
+	int column_index;
+	fill_type_t type;
+	void *data;
+} fill_target_t;
+
+typedef struct fill_baton_t {
+	task_t task;
+	statement_t *statement;
+	void (*c_callback)(struct fill_baton_t *);
+	void *js_callback;
+	int js_callback_owned;
+	void *wrapper; // the StatementWrapper, which owns the targets and pins their arrays
+	const fill_target_t *targets;
+	int target_count;
+	size_t max_rows;
+	size_t rows;
+	int status;
+} fill_baton_t;
+
+ASYNC_HEADER(fill)
+void fill_schedule(fill_baton_t *baton);
 
 #ifdef __cplusplus
 }
@@ -1,12 +1,234 @@
 #include <stdlib.h>
+#include <string.h>
 #include "statement.h"
 
-statement_t *statement_new(void) {
-	statement_t *statement = malloc(sizeof(statement_t));
+// Steps whose moving average stays below this many nanoseconds run on the
+// loop thread instead of a worker. Zero turns adaptive execution off.
+static uint64_t inline_threshold = 0;
+
+// A statement has to be timed this many times before it may run inline.
+#define MIN_STEP_SAMPLES 4
+
+statement_t *statement_new(db_t *db) {
+	statement_t *statement = calloc(1, sizeof(statement_t));
 	statement->sqlite_statement = NULL;
+	statement->db = db;
 	return statement;
 }
 
+static void statement_free_plan(statement_t *statement) {
+	for (int i = 0; i < statement->column_count; i++) {
+		free(statement->columns[i].name);
+	}
+	free(statement->columns);
+	statement->columns = NULL;
+	statement->column_count = 0;
+}
+
+static void statement_free_timer(uv_handle_t *handle) {
+	free(handle);
+}
+
 void statement_free(statement_t *statement) {
+	statement_free_plan(statement);
+	free(statement->tasks);
+	if (statement->deadline_timer != NULL) {
+		uv_close((uv_handle_t*)statement->deadline_timer, statement_free_timer);
+	}
 	free(statement);
+}
+
+static void statement_expire(uv_timer_t *timer, int status);
+
+// Wakes the loop at the earliest deadline of an operation still to run.
+static void statement_arm_timer(statement_t *statement) {
+	const uint64_t now = uv_hrtime();
+	uint64_t next = 0;
+	for (unsigned int i = 0; i < statement->task_count; i++) {
+		const task_t *task = statement->tasks[i];
+		if (task->deadline > now && (next == 0 || task->deadline < next)) {
+			next = task->deadline;
+		}
+	}
+	
+	if (next == 0) {
+		uv_timer_stop(statement->deadline_timer);
+	} else {
+		uv_timer_start(statement->deadline_timer, statement_expire, (next - now + 999999) / 1000000, 0);
+	}
+}
+
+// Fails operations whose deadline has passed before they could run, so that
+// they do not wait for a worker only to be interrupted. The oldest one is
+// completed right away if it is still queued; held ones fail as soon as
+// the operations before them are done. A running operation is interrupted
+// by the progress handler instead.
+static void statement_expire(uv_timer_t *timer, int status) {
+	statement_t *statement = (statement_t*)timer->data;
+	const uint64_t now = uv_hrtime();
+	for (unsigned int i = 0; i < statement->task_count; i++) {
+		task_t *task = statement->tasks[i];
+		if (task->deadline == 0 || task->deadline > now || task_finished(task)) {
+			continue;
+		}
+		
+		task_cancel(task);
+		if (i == 0 && pool_cancel(task)) {
+			task->run(task);
+		}
+	}
+	statement_arm_timer(statement);
+}
+
+// Operations of a statement run one at a time and in the order they were
+// scheduled, so that they never hold a worker while waiting for each other
+// and complete in order. Returns 1 if the task may be submitted right away,
+// or 0 if it has to be held until the operations before it are done.
+// Called on the loop thread. The array only ever grows, so a statement that
+// is polled allocates nothing once warm.
+int statement_track(statement_t *statement, task_t *task) {
+	if (statement->task_count == statement->task_capacity) {
+		statement->task_capacity = statement->task_capacity == 0 ? 4 : statement->task_capacity * 2;
+		statement->tasks = realloc(statement->tasks, statement->task_capacity * sizeof(task_t*));
+	}
+	statement->tasks[statement->task_count++] = task;
+	
+	if (task->deadline != 0) {
+		if (statement->deadline_timer == NULL) {
+			statement->deadline_timer = malloc(sizeof(uv_timer_t));
+			uv_timer_init(uv_default_loop(), statement->deadline_timer);
+			statement->deadline_timer->data = statement;
+			
+			// pending operations already keep the loop alive
+			uv_unref((uv_handle_t*)statement->deadline_timer);
+		}
+		statement_arm_timer(statement);
+	}
+	return statement->task_count == 1;
+}
+
+// Called on the loop thread once the operation's callback has run, and
+// submits the next operation held for the statement.
+void statement_untrack(statement_t *statement, task_t *task) {
+	for (unsigned int i = 0; i < statement->task_count; i++) {
+		if (statement->tasks[i] == task) {
+			memmove(statement->tasks + i, statement->tasks + i + 1, (statement->task_count - i - 1) * sizeof(task_t*));
+			statement->task_count--;
+			
+			if (i == 0 && statement->task_count > 0) {
+				db_submit(statement->db, statement->tasks[0]);
+			}
+			return;
+		}
+	}
+}
+
+// Cancels the oldest operation that has not finished running, which is the
+// one running unless it is still waiting for a worker, in which case it is
+// taken out of the queue and completed right away. An operation that has
+// run but whose callback is still pending is left alone.
+int statement_cancel(statement_t *statement) {
+	for (unsigned int i = 0; i < statement->task_count; i++) {
+		task_t *task = statement->tasks[i];
+		if (task_finished(task)) {
+			continue;
+		}
+		
+		task_cancel(task);
+		if (pool_cancel(task)) {
+			task->run(task);
+		}
+		return 1;
+	}
+	return 0;
+}
+
+static int contains(const char *haystack, const char *needle) {
+	const size_t needle_length = strlen(needle);
+	for (; *haystack != '\0'; haystack++) {
+		if (sqlite3_strnicmp(haystack, needle, (int)needle_length) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static column_affinity_t affinity_of(const char *declared_type) {
+	if (declared_type == NULL) {
+		return column_affinity_unknown;
+	} else if (contains(declared_type, "INT")) {
+		return column_affinity_integer;
+	} else if (contains(declared_type, "CHAR") || contains(declared_type, "CLOB") || contains(declared_type, "TEXT")) {
+		return column_affinity_text;
+	} else if (*declared_type == '\0' || contains(declared_type, "BLOB")) {
+		return column_affinity_blob;
+	} else if (contains(declared_type, "REAL") || contains(declared_type, "FLOA") || contains(declared_type, "DOUB")) {
+		return column_affinity_real;
+	} else {
+		return column_affinity_numeric;
+	}
+}
+
+// Called once sqlite3_prepare_v2 has succeeded, on the thread that prepared
+// the statement. Copies the names, which sqlite may free on a re-prepare.
+void statement_capture_plan(statement_t *statement) {
+	statement_free_plan(statement);
+	statement->plan_generation++;
+	
+	sqlite3_stmt *stmt = statement->sqlite_statement;
+	const int column_count = sqlite3_column_count(stmt);
+	if (column_count == 0) {
+		return;
+	}
+	
+	statement->columns = malloc(column_count * sizeof(column_plan_t));
+	for (int i = 0; i < column_count; i++) {
+		statement->columns[i].name = strdup(sqlite3_column_name(stmt, i));
+		statement->columns[i].affinity = affinity_of(sqlite3_column_decltype(stmt, i));
+	}
+	statement->column_count = column_count;
+}
+
+// The plan is fixed at prepare time, while sqlite may re-prepare after a
+// schema change; columns beyond it are looked up directly.
+const char *statement_column_name(statement_t *statement, int column_index) {
+	if (column_index < statement->column_count) {
+		return statement->columns[column_index].name;
+	}
+	return sqlite3_column_name(statement->sqlite_statement, column_index);
+}
+
+column_affinity_t statement_column_affinity(statement_t *statement, int column_index) {
+	if (column_index < statement->column_count) {
+		return statement->columns[column_index].affinity;
+	}
+	return column_affinity_unknown;
+}
+
+uint64_t statement_inline_threshold(void) {
+	return inline_threshold;
+}
+
+void statement_set_inline_threshold(uint64_t nanoseconds) {
+	inline_threshold = nanoseconds;
+}
+
+// Exponential moving average with a weight of 1/8 for the newest sample.
+// Steps of one statement never overlap, so the plain updates are enough.
+void statement_record_step(statement_t *statement, uint64_t nanoseconds) {
+	if (statement->step_samples == 0) {
+		statement->step_time_average = nanoseconds;
+	} else {
+		statement->step_time_average = statement->step_time_average - (statement->step_time_average >> 3) + (nanoseconds >> 3);
+	}
+	
+	if (statement->step_samples < MIN_STEP_SAMPLES) {
+		statement->step_samples++;
+	}
+}
+
+int statement_prefers_inline(statement_t *statement, int steps) {
+	return inline_threshold > 0
+		&& statement->step_samples >= MIN_STEP_SAMPLES
+		&& statement->step_time_average * steps < inline_threshold;
 }
\ No newline at end of file
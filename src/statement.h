@@ -1,6 +1,8 @@
 #ifndef __BS_STATEMENT_H__
 #define __BS_STATEMENT_H__
 
+#include <stdint.h>
+#include "db.h"
 #include "sqlite3/sqlite3.h"
 
 #ifdef __cplusplus
@@ -8,13 +10,56 @@ extern "C"
 {
 #endif
 
+// Affinity of a result column, derived from its declared type with the
+// rules of section 2.1 of https://www.sqlite.org/datatype3.html. Columns
+// that are expressions have no declared type and an unknown affinity.
+typedef enum column_affinity_t {
+	column_affinity_unknown = 0,
+	column_affinity_integer,
+	column_affinity_real,
+	column_affinity_numeric,
+	column_affinity_text,
+	column_affinity_blob
+} column_affinity_t;
+
+typedef struct column_plan_t {
+	char *name;
+	column_affinity_t affinity;
+} column_plan_t;
+
 typedef struct statement_t {
 	sqlite3_stmt *sqlite_statement;
+	db_t *db;
+	pool_lane_t lane;
+	task_t **tasks; // operations in flight, oldest first, only the first submitted
+	unsigned int task_count;
+	unsigned int task_capacity;
+	uv_timer_t *deadline_timer; // created for the first operation with a deadline
+	uint64_t step_time_average;
+	unsigned int step_samples;
+	unsigned long inline_steps;
+	unsigned long offloaded_steps;
+	int column_count; // column plan, captured once the statement is prepared
+	column_plan_t *columns;
+	unsigned int plan_generation; // changes whenever the plan is captured
 } statement_t;
 
-statement_t *statement_new(void);
+statement_t *statement_new(db_t *db);
 void statement_free(statement_t *db);
 
+int statement_track(statement_t *statement, task_t *task);
+void statement_untrack(statement_t *statement, task_t *task);
+int statement_cancel(statement_t *statement);
+
+void statement_capture_plan(statement_t *statement);
+const char *statement_column_name(statement_t *statement, int column_index);
+column_affinity_t statement_column_affinity(statement_t *statement, int column_index);
+
+uint64_t statement_inline_threshold(void);
+void statement_set_inline_threshold(uint64_t nanoseconds);
+void statement_record_step(statement_t *statement, uint64_t nanoseconds);
+int statement_prefers_inline(statement_t *statement, int steps);
+
 #ifdef __cplusplus
 }
 #endif
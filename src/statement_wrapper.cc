@@ -6,16 +6,188 @@ static const char *const className = "StatementWrapper";
 
 Persistent<Function> StatementWrapper::constructor;
 
-StatementWrapper::StatementWrapper() : statement(NULL) {
+StatementWrapper::StatementWrapper() : statement(NULL), filling(false), binding_generation(0), row_template_plan(0), row_template_columns(0),
+	lazy_row_template_plan(0), lazy_row_template_columns(0) {
 }
 
 StatementWrapper::~StatementWrapper() {
+	ReleaseHandles();
 	if (statement != NULL) {
 		statement_free(statement);
 		statement = NULL;
 	}
 }
 
+void StatementWrapper::ReleaseHandles() {
+	if (!step_callback.IsEmpty()) {
+		step_callback.Dispose();
+		step_callback.Clear();
+	}
+	if (!fill_callback.IsEmpty()) {
+		fill_callback.Dispose();
+		fill_callback.Clear();
+	}
+	if (!result_callback.IsEmpty()) {
+		result_callback.Dispose();
+		result_callback.Clear();
+	}
+	if (!row_template.IsEmpty()) {
+		row_template.Dispose();
+		row_template.Clear();
+	}
+	ReleaseColumnNames();
+	if (!lazy_row_template.IsEmpty()) {
+		lazy_row_template.Dispose();
+		lazy_row_template.Clear();
+	}
+	UnpinBindings();
+	UnpinFillTargets(0);
+}
+
+// Templates are built from the column plan, so they are rebuilt whenever the
+// plan is captured again. The column count is checked as well because a
+// re-prepare after a schema change may add columns the plan does not know.
+bool StatementWrapper::TemplateIsCurrent(unsigned int template_plan, int template_columns, int column_count) {
+	return template_plan == statement->plan_generation && template_columns == column_count;
+}
+
+// Lazy rows declare every column as a read-only accessor whose data is the
+// column index, and have internal fields for the getter to find the values.
+Local<Object> StatementWrapper::NewLazyRow(int column_count, AccessorGetter getter) {
+	if (lazy_row_template.IsEmpty() || !TemplateIsCurrent(lazy_row_template_plan, lazy_row_template_columns, column_count)) {
+		if (!lazy_row_template.IsEmpty()) {
+			lazy_row_template.Dispose();
+		}
+		
+		auto tpl = ObjectTemplate::New();
+		tpl->SetInternalFieldCount(LAZY_ROW_FIELD_COUNT);
+		for (int i = 0; i < column_count; i++) {
+			tpl->SetAccessor(String::NewSymbol(statement_column_name(statement, i)), getter, 0,
+				Integer::New(i), DEFAULT, ReadOnly);
+		}
+		lazy_row_template = Persistent<ObjectTemplate>::New(tpl);
+		lazy_row_template_plan = statement->plan_generation;
+		lazy_row_template_columns = column_count;
+	}
+	
+	return lazy_row_template->NewInstance();
+}
+
+// Blobs are bound as SQLITE_STATIC, so the object owning their memory is
+// kept alive for as long as it stays bound. An empty handle unpins the
+// parameter.
+void StatementWrapper::PinBinding(int index, Handle<Object> value) {
+	if (index < 1) {
+		return;
+	}
+	binding_generation++;
+	
+	if (pinned_bindings.size() < static_cast<size_t>(index)) {
+		if (value.IsEmpty()) {
+			return;
+		}
+		pinned_bindings.resize(index);
+	}
+	
+	auto& pinned = pinned_bindings[index - 1];
+	if (!pinned.IsEmpty()) {
+		pinned.Dispose();
+		pinned.Clear();
+	}
+	if (!value.IsEmpty()) {
+		pinned = Persistent<Object>::New(value);
+		async_allocation_count++;
+	}
+}
+
+void StatementWrapper::UnpinBindings() {
+	binding_generation++;
+	for (auto& pinned : pinned_bindings) {
+		if (!pinned.IsEmpty()) {
+			pinned.Dispose();
+			pinned.Clear();
+		}
+	}
+	pinned_bindings.clear();
+}
+
+// Drops the pins of the first `count` parameters once a worker job has bound
+// values of its own over them, without counting as a bind.
+void StatementWrapper::ReleaseBindings(int count) {
+	for (size_t i = 0; i < pinned_bindings.size() && i < static_cast<size_t>(count); i++) {
+		if (!pinned_bindings[i].IsEmpty()) {
+			pinned_bindings[i].Dispose();
+			pinned_bindings[i].Clear();
+		}
+	}
+}
+
+// The worker writes into the backing store of each fill target, so every
+// array is kept alive on its own. The pins stay in place between fills, and
+// a caller that polls with the same arrays never creates another handle.
+void StatementWrapper::PinFillTarget(size_t slot, Handle<Object> array) {
+	if (pinned_fill_targets.size() <= slot) {
+		pinned_fill_targets.resize(slot + 1);
+	}
+	
+	auto& pinned = pinned_fill_targets[slot];
+	if (!pinned.IsEmpty()) {
+		if (pinned->StrictEquals(array)) {
+			return;
+		}
+		pinned.Dispose();
+	}
+	pinned = Persistent<Object>::New(array);
+	async_allocation_count++;
+}
+
+void StatementWrapper::UnpinFillTargets(size_t from) {
+	for (size_t i = from; i < pinned_fill_targets.size(); i++) {
+		if (!pinned_fill_targets[i].IsEmpty()) {
+			pinned_fill_targets[i].Dispose();
+		}
+	}
+	if (from < pinned_fill_targets.size()) {
+		pinned_fill_targets.resize(from);
+	}
+}
+
+// Rows are instantiated from a template holding every column name, so all
+// rows of a statement share one hidden class. The column names handed out by
+// ColumnName are rebuilt along with it.
+Local<Object> StatementWrapper::NewRow(int column_count) {
+	if (row_template.IsEmpty() || !TemplateIsCurrent(row_template_plan, row_template_columns, column_count)) {
+		if (!row_template.IsEmpty()) {
+			row_template.Dispose();
+		}
+		
+		ReleaseColumnNames();
+		auto tpl = ObjectTemplate::New();
+		for (int i = 0; i < column_count; i++) {
+			auto name = String::NewSymbol(statement_column_name(statement, i));
+			tpl->Set(name, Null());
+			column_names.push_back(Persistent<String>::New(name));
+		}
+		row_template = Persistent<ObjectTemplate>::New(tpl);
+		row_template_plan = statement->plan_generation;
+		row_template_columns = column_count;
+	}
+	
+	return row_template->NewInstance();
+}
+
+// Keys of the rows made by NewRow, which must have been called first.
+Handle<String> StatementWrapper::ColumnName(int column_index) {
+	return column_names[column_index];
+}
+
+void StatementWrapper::ReleaseColumnNames() {
+	for (auto& name : column_names) {
+		name.Dispose();
+	}
+	column_names.clear();
+}
+
 void StatementWrapper::Init(Handle<Object> exports) {
 	// Prepare constructor template
 	auto tpl = FunctionTemplate::New(New);
@@ -1,12 +1,38 @@
 #ifndef __BS_STATEMENT_WRAPPER_H__
 #define __BS_STATEMENT_WRAPPER_H__
 
+#include <vector>
 #include <node.h>
+#include "results.h"
 #include "statement.h"
 
+// Internal fields of lazy rows: the row_t, the ResultWrapper owning it and an
+// array caching the values decoded so far.
+#define LAZY_ROW_FIELD_ROW 0
+#define LAZY_ROW_FIELD_RESULT 1
+#define LAZY_ROW_FIELD_CACHE 2
+#define LAZY_ROW_FIELD_COUNT 3
+
 class StatementWrapper final : public node::ObjectWrap {
 public:
 	statement_t *statement;
+	v8::Persistent<v8::Function> step_callback;
+	v8::Persistent<v8::Function> fill_callback;
+	v8::Persistent<v8::Function> result_callback; // shared by all, get, columns and fetchPacked
+	std::vector<fill_target_t> fill_targets; // reused by every fill, of which one runs at a time
+	bool filling;
+	v8::Local<v8::Object> NewRow(int column_count);
+	v8::Handle<v8::String> ColumnName(int column_index);
+	v8::Local<v8::Object> NewLazyRow(int column_count, v8::AccessorGetter getter);
+	unsigned int binding_generation; // bumped by every bind and clear on the loop thread
+	void PinBinding(int index, v8::Handle<v8::Object> value);
+	void UnpinBindings();
+	void ReleaseBindings(int count);
+	void PinFillTarget(size_t slot, v8::Handle<v8::Object> array);
+	void UnpinFillTargets(size_t from);
+	void ReleaseHandles();
+	using node::ObjectWrap::Ref; // held by a prepare, which reports the wrapper back
+	using node::ObjectWrap::Unref;
 	static void Init(v8::Handle<v8::Object> exports);
 
 private:
@@ -14,6 +40,17 @@ private:
 	~StatementWrapper();
 	static v8::Handle<v8::Value> New(const v8::Arguments& args);
 	static v8::Persistent<v8::Function> constructor;
+	bool TemplateIsCurrent(unsigned int template_plan, int template_columns, int column_count);
+	v8::Persistent<v8::ObjectTemplate> row_template;
+	unsigned int row_template_plan;
+	int row_template_columns;
+	std::vector<v8::Persistent<v8::String>> column_names;
+	void ReleaseColumnNames();
+	v8::Persistent<v8::ObjectTemplate> lazy_row_template;
+	unsigned int lazy_row_template_plan;
+	int lazy_row_template_columns;
+	std::vector<v8::Persistent<v8::Object>> pinned_bindings;
+	std::vector<v8::Persistent<v8::Object>> pinned_fill_targets;
 };
 
 #endif /* __BS_STATEMENT_WRAPPER_H__ */
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include "worker.h"
+
+static void worker_loop(void *arg) {
+	worker_t *worker = (worker_t*)arg;
+	
+	for (;;) {
+		task_t *task;
+		uv_sem_wait(&worker->pending);
+		
+		// the semaphore guarantees a task is on its way, a NULL here only
+		// means its producer has not finished linking it yet
+		while ((task = queue_pop(&worker->queue)) == NULL);
+		
+		if (task == &worker->quit) {
+			return;
+		}
+		task->run(task);
+	}
+}
+
+worker_t *worker_new(void) {
+	worker_t *worker = calloc(1, sizeof(worker_t));
+	queue_init(&worker->queue);
+	uv_sem_init(&worker->pending, 0);
+	uv_thread_create(&worker->thread, worker_loop, worker);
+	return worker;
+}
+
+void worker_submit(worker_t *worker, task_t *task) {
+	queue_push(&worker->queue, task);
+	uv_sem_post(&worker->pending);
+}
+
+void worker_free(worker_t *worker) {
+	worker_submit(worker, &worker->quit);
+	uv_thread_join(&worker->thread);
+	uv_sem_destroy(&worker->pending);
+	free(worker);
+}
\ No newline at end of file
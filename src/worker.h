@@ -0,0 +1,33 @@
+#ifndef __BS_WORKER_H__
+#define __BS_WORKER_H__
+
+#include <uv.h>
+#include "pool.h"
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//
+// A single thread owned by one connection. Tasks run strictly in the order
+// they were submitted, so their priority lane is not taken into account.
+//
+
+typedef struct worker_t {
+	uv_thread_t thread;
+	uv_sem_t pending;
+	queue_t queue;
+	task_t quit;
+} worker_t;
+
+worker_t *worker_new(void);
+void worker_submit(worker_t *worker, task_t *task);
+void worker_free(worker_t *worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BS_WORKER_H__ */
\ No newline at end of file
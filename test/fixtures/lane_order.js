@@ -0,0 +1,84 @@
+// Run by the lane order test in a process of its own, with a pool of a
+// single thread so that operations are taken one at a time. Reports the
+// order in which the queued steps complete, then waits to be killed.
+var sqlite = require('../..').lowLevel;
+
+var QUEUED_PER_LANE = 6;
+
+function fail(err) {
+	process.send({
+		error: err.message
+	});
+}
+
+function prepareAll(db, count, statements, callback) {
+	if (statements.length === count) {
+		return callback();
+	}
+
+	db.prepare('select 1', function(err, stmt) {
+		if (err) {
+			return fail(err);
+		}
+		statements.push(stmt);
+		prepareAll(db, count, statements, callback);
+	});
+}
+
+sqlite.open(':memory:', function(err, db) {
+	if (err) {
+		return fail(err);
+	}
+
+	var statements = [];
+	prepareAll(db, 2 * QUEUED_PER_LANE, statements, function() {
+		db.prepare('with recursive c(x) as (select 1 union all select x + 1 from c where x < 2000000) select count(*) from c', function(err, busy) {
+			if (err) {
+				return fail(err);
+			}
+
+			var order = [];
+			var onStep = function(lane) {
+				return function(err) {
+					if (err) {
+						return fail(err);
+					}
+
+					order.push(lane);
+					if (order.length === 2 * QUEUED_PER_LANE) {
+						process.send({
+							order: order
+						});
+					}
+				};
+			};
+
+			// keeps the only worker busy until both lanes have been filled
+			busy.step({
+				priority: 'background'
+			}, function(err) {
+				if (err) {
+					fail(err);
+				}
+			});
+
+			var queue = function() {
+				if (sqlite.queueDepths().background > 0) {
+					return setImmediate(queue);
+				}
+
+				for (var i = 0; i < QUEUED_PER_LANE; i++) {
+					statements[i].step({
+						priority: 'background'
+					}, onStep('background'));
+				}
+				for (var j = QUEUED_PER_LANE; j < 2 * QUEUED_PER_LANE; j++) {
+					statements[j].step({
+						priority: 'interactive'
+					}, onStep('interactive'));
+				}
+			};
+			queue();
+		});
+	});
+});
\ No newline at end of file
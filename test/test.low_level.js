@@ -1,5 +1,7 @@
 var assert = require('assert');
+var childProcess = require('child_process');
 var fs = require('fs');
+var path = require('path');
 var Q = require('q');
 var sqlite = require('..').lowLevel;
 
@@ -25,6 +27,106 @@ describe('low level', function() {
 				.fail(makeReportError(scope));
 		});
 
+		it('dedicated thread', function() {
+			var scope = {
+				filename: './db_dedicated_thread_test.db'
+			};
+
+			return Q
+				.ninvoke(sqlite, 'open', scope.filename, {
+					dedicatedThread: true
+				})
+				.then(function(db) {
+					scope.db = db;
+					return makeTable('integer')(scope.db);
+				})
+				.then(function() {
+					return Q.ninvoke(scope.db, 'prepare', 'insert into test_table_0 (id, col_1) values (7, 49)');
+				})
+				.then(function(stmt) {
+					scope.stmt = stmt;
+					return Q.ninvoke(stmt, 'step');
+				})
+				.then(function(code) {
+					assert.strictEqual(code, sqlite.errorCodes.SQLITE_DONE);
+					assert.strictEqual(scope.db.lastInsertRowId(), 7);
+				})
+				.fin(makeCloseStatementAndDb(scope))
+				.fin(makeCleanup(scope))
+				.fail(makeReportError(scope));
+		});
+
+		it('promises', function() {
+			var scope = {
+				filename: './db_promises_test.db'
+			};
+
+			sqlite.setPromiseConstructor(Q.Promise);
+			return sqlite
+				.open(scope.filename)
+				.then(function(db) {
+					scope.db = db;
+					return db.prepare('select 100;');
+				})
+				.then(function(stmt) {
+					scope.stmt = stmt;
+					return stmt.step();
+				})
+				.then(function(code) {
+					assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+					assert.strictEqual(scope.stmt.columnInteger(0), 100);
+					return scope.stmt.stepN(5);
+				})
+				.then(function(result) {
+					assert.deepEqual(result, [sqlite.errorCodes.SQLITE_DONE, 0]);
+					scope.stmt.finalize();
+					delete scope.stmt;
+					var db = scope.db;
+					delete scope.db;
+					return db.close();
+				})
+				.fin(makeCloseStatementAndDb(scope))
+				.fin(makeCleanup(scope))
+				.fail(makeReportError(scope));
+		});
+
+		it('no allocations in steady state', function() {
+			var scope = {
+				filename: './db_allocations_test.db'
+			};
+
+			function openPrepareClose(count) {
+				return sqlite
+					.open(scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return db.prepare('select 1;');
+					})
+					.then(function(stmt) {
+						stmt.finalize();
+						var db = scope.db;
+						delete scope.db;
+						return db.close();
+					})
+					.then(function() {
+						return count > 1 ? openPrepareClose(count - 1) : null;
+					});
+			}
+
+			sqlite.setPromiseConstructor(Q.Promise);
+			return openPrepareClose(1)
+				.then(function() {
+					scope.allocations = sqlite.allocationCount();
+					return openPrepareClose(10);
+				})
+				.then(function() {
+					assert.strictEqual(sqlite.allocationCount(), scope.allocations);
+				})
+				.fin(makeCloseStatementAndDb(scope))
+				.fin(makeCleanup(scope))
+				.fail(makeReportError(scope));
+		});
+
 		it('get autocommit', function() {
 			var scope = {
 				filename: './db_get_autocommit_test.db'
@@ -133,6 +235,33 @@ describe('low level', function() {
 			var version = sqlite.version();
 			assert.strictEqual(version, '3.8.4.2');
 		});
+
+		it('pool size', function() {
+			var scope = {
+				filename: './db_pool_size_test.db'
+			};
+
+			// opening runs on the pool, which can no longer be resized once
+			// it has started
+			return Q
+				.ninvoke(sqlite, 'open', scope.filename)
+				.then(function(db) {
+					scope.db = db;
+					var size = sqlite.poolSize();
+					assert.strictEqual(size, parseInt(size, 10));
+					assert.ok(size >= 1);
+					assert.throws(function() {
+						sqlite.setPoolSize(0);
+					});
+					assert.throws(function() {
+						sqlite.setPoolSize(size + 1);
+					});
+					assert.strictEqual(sqlite.poolSize(), size);
+				})
+				.fin(makeCloseStatementAndDb(scope))
+				.fin(makeCleanup(scope))
+				.fail(makeReportError(scope));
+		});
 	});
 
 	describe('statement', function() {
@@ -317,6 +446,47 @@ describe('low level', function() {
 					.fin(makeCleanup(scope))
 					.fail(makeReportError(scope));
 			});
+
+			it('failed rebind keeps the buffer bound', function() {
+				var scope = {
+					filename: './stmt_bind_failed_rebind_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select ?');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						stmt.bind(new Buffer([1, 2, 3]), 1);
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+						assert.throws(function() {
+							scope.stmt.bind(new Buffer([9, 9]), 1);
+						}, function(err) {
+							return err.code === sqlite.errorCodes.SQLITE_MISUSE;
+						});
+
+						// only the pin keeps the first buffer alive now, run with
+						// --expose-gc to check it held
+						if (global.gc) {
+							global.gc();
+						}
+						scope.stmt.reset();
+						return Q.ninvoke(scope.stmt, 'step');
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+						assert.deepEqual(Array.prototype.slice.call(scope.stmt.columnBlob(0)), [1, 2, 3]);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
 		});
 
 		describe('step', function() {
@@ -345,59 +515,1385 @@ describe('low level', function() {
 					.fin(makeCleanup(scope))
 					.fail(makeReportError(scope));
 			});
-		});
 
-		describe('column', function() {
-			it('count', function() {
+			it('step n', function() {
 				var scope = {
-					filename: './stmt_column_count_test.db'
+					filename: './stmt_step_n_test.db'
 				};
 
 				return Q
 					.ninvoke(sqlite, 'open', scope.filename)
 					.then(function(db) {
 						scope.db = db;
-						return makeTable('text')(scope.db);
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x from c');
 					})
-					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (100, \'hello\')'))
-					.then(function() {
-						return Q.ninvoke(scope.db, 'prepare', 'select id, col_1, 10, 20, 30, 40, 50, 60, 70, 80 from test_table_0');
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'stepN', 40);
+					})
+					.then(function(result) {
+						assert.deepEqual(result, [sqlite.errorCodes.SQLITE_ROW, 40]);
+						assert.strictEqual(scope.stmt.columnInteger(0), 40);
+						return Q.ninvoke(scope.stmt, 'stepN', 100);
+					})
+					.then(function(result) {
+						assert.deepEqual(result, [sqlite.errorCodes.SQLITE_DONE, 60]);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('background priority', function() {
+				var scope = {
+					filename: './stmt_step_priority_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select 100;', {
+							priority: 'background'
+						});
 					})
 					.then(function(stmt) {
 						scope.stmt = stmt;
-						return Q.ninvoke(stmt, 'step');
+						var depths = sqlite.queueDepths();
+						assert.strictEqual(depths.interactive, parseInt(depths.interactive, 10));
+						assert.strictEqual(depths.background, parseInt(depths.background, 10));
+						assert.throws(function() {
+							stmt.step({
+								priority: 'urgent'
+							}, function() {});
+						});
+						return Q.ninvoke(stmt, 'step', {
+							priority: 'interactive'
+						});
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.columnInteger(0), 100);
+						return Q.ninvoke(scope.stmt, 'step');
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_DONE);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('lane order', function() {
+				this.timeout(10000);
+
+				var env = {};
+				Object.keys(process.env).forEach(function(name) {
+					env[name] = process.env[name];
+				});
+				env.BETTER_SQLITE_POOL_SIZE = '1';
+
+				// interactive steps are taken first, but every fifth one is a
+				// waiting background step so that the lane cannot starve
+				return Q.Promise(function(resolve, reject) {
+					var child = childProcess.fork(path.join(__dirname, 'fixtures', 'lane_order.js'), [], {
+						env: env
+					});
+					child.on('message', function(message) {
+						child.kill();
+						if (message.error) {
+							reject(new Error(message.error));
+						} else {
+							resolve(message.order);
+						}
+					});
+					child.on('exit', function(code) {
+						reject(new Error('lane order fixture exited with ' + code));
+					});
+				}).then(function(order) {
+					assert.deepEqual(order, [
+						'interactive', 'interactive', 'interactive', 'interactive', 'background',
+						'interactive', 'interactive', 'background', 'background', 'background',
+						'background', 'background'
+					]);
+				});
+			});
+
+			it('timeout', function() {
+				var scope = {
+					filename: './stmt_step_timeout_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c) select count(*) from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step', {
+							timeout: 50
+						});
 					})
 					.then(function() {
-						var datatypeCode = scope.stmt.columnCount();
-						assert.strictEqual(datatypeCode, 10);
+						assert.fail('no error raised');
+					}, function(err) {
+						assert.strictEqual(err.code, sqlite.errorCodes.SQLITE_INTERRUPT);
 					})
 					.fin(makeCloseStatementAndDb(scope))
 					.fin(makeCleanup(scope))
 					.fail(makeReportError(scope));
 			});
 
-			it('type', function() {
+			it('timeout pipelined', function() {
+				this.timeout(10000);
 				var scope = {
-					filename: './stmt_column_type_test.db'
+					filename: './stmt_step_timeout_pipelined_test.db'
 				};
 
 				return Q
 					.ninvoke(sqlite, 'open', scope.filename)
 					.then(function(db) {
 						scope.db = db;
-						return makeTable('text')(scope.db);
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 2000000) select count(*) from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						var steps = [Q.defer(), Q.defer(), Q.defer()];
+						stmt.step(steps[0].makeNodeResolver());
+						stmt.step({
+							timeout: 50
+						}, steps[1].makeNodeResolver());
+						stmt.step({
+							timeout: 60000
+						}, steps[2].makeNodeResolver());
+						return Q.allSettled(steps.map(function(step) {
+							return step.promise;
+						}));
+					})
+					.then(function(results) {
+						// only the step whose own timeout elapsed fails
+						assert.strictEqual(results[0].value, sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(results[1].state, 'rejected');
+						assert.strictEqual(results[1].reason.code, sqlite.errorCodes.SQLITE_INTERRUPT);
+						assert.strictEqual(results[2].value, sqlite.errorCodes.SQLITE_DONE);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('abort', function() {
+				var scope = {
+					filename: './stmt_step_abort_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c) select count(*) from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						assert.strictEqual(stmt.abort(), false);
+						var deferred = Q.defer();
+						stmt.step(deferred.makeNodeResolver());
+						assert.strictEqual(stmt.abort(), true);
+						return deferred.promise;
 					})
-					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (100, \'hello\')'))
 					.then(function() {
-						return Q.ninvoke(scope.db, 'prepare', 'select col_1 from test_table_0');
+						assert.fail('no error raised');
+					}, function(err) {
+						assert.strictEqual(err.code, sqlite.errorCodes.SQLITE_INTERRUPT);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('abort pipelined', function() {
+				this.timeout(10000);
+				var scope = {
+					filename: './stmt_step_abort_pipelined_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 1000000) select count(*) from c');
 					})
 					.then(function(stmt) {
 						scope.stmt = stmt;
-						return Q.ninvoke(stmt, 'step');
+						var first = Q.defer();
+						var second = Q.defer();
+						stmt.step(first.makeNodeResolver());
+						stmt.step(second.makeNodeResolver());
+
+						// the oldest step is the one cancelled, not the latest
+						assert.strictEqual(stmt.abort(), true);
+						return Q.allSettled([first.promise, second.promise]);
+					})
+					.then(function(results) {
+						assert.strictEqual(results[0].state, 'rejected');
+						assert.strictEqual(results[0].reason.code, sqlite.errorCodes.SQLITE_INTERRUPT);
+						assert.strictEqual(results[1].state, 'fulfilled');
+						assert.strictEqual(results[1].value, sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.columnInteger(0), 1000000);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('abort after inline step', function() {
+				var scope = {
+					filename: './stmt_step_abort_inline_test.db'
+				};
+
+				function stepTimes(count) {
+					return count === 0 ? Q() : Q.ninvoke(scope.stmt, 'step').then(function() {
+						return stepTimes(count - 1);
+					});
+				}
+
+				sqlite.setInlineStepThreshold(1000000);
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return stepTimes(8);
 					})
 					.then(function() {
-						var datatypeCode = scope.stmt.columnType(0);
-						assert.strictEqual(datatypeCode, sqlite.datatypeCodes.SQLITE_TEXT);
+						var inline = scope.stmt.stepStats().inline;
+						var deferred = Q.defer();
+						scope.stmt.step(deferred.makeNodeResolver());
+
+						// the step has already run, only its callback is pending
+						assert.strictEqual(scope.stmt.stepStats().inline, inline + 1);
+						assert.strictEqual(scope.stmt.abort(), false);
+						return deferred.promise;
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+					})
+					.fin(function() {
+						sqlite.setInlineStepThreshold(0);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('adaptive', function() {
+				var scope = {
+					filename: './stmt_step_adaptive_test.db',
+					steps: 0
+				};
+
+				function stepToEnd() {
+					scope.steps++;
+					return Q.ninvoke(scope.stmt, 'step').then(function(code) {
+						return code === sqlite.errorCodes.SQLITE_ROW ? stepToEnd() : code;
+					});
+				}
+
+				sqlite.setInlineStepThreshold(1000000);
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return stepToEnd();
+					})
+					.then(function(code) {
+						var stats = scope.stmt.stepStats();
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_DONE);
+						assert.strictEqual(stats.inline + stats.offloaded, scope.steps);
+						assert.ok(stats.inline > 0);
+						assert.ok(stats.offloaded > 0);
+					})
+					.fin(function() {
+						sqlite.setInlineStepThreshold(0);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('finalize while stepping', function() {
+				var scope = {
+					filename: './stmt_step_finalize_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100000) select count(*) from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						var deferred = Q.defer();
+						stmt.step(deferred.makeNodeResolver());
+						assert.throws(function() {
+							stmt.finalize();
+						}, function(err) {
+							return err.code === sqlite.errorCodes.SQLITE_MISUSE;
+						});
+						return deferred.promise;
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.columnInteger(0), 100000);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('sync step while an operation is in flight', function() {
+				var scope = {
+					filename: './stmt_step_sync_busy_test.db'
+				};
+
+				var isMisuse = function(err) {
+					return err.code === sqlite.errorCodes.SQLITE_MISUSE;
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 1000) select x from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						var deferred = Q.defer();
+						stmt.all(deferred.makeNodeResolver());
+						assert.throws(function() {
+							stmt.stepSync();
+						}, isMisuse);
+						assert.throws(function() {
+							stmt.runSync();
+						}, isMisuse);
+						return deferred.promise;
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 1000);
+						assert.strictEqual(scope.stmt.stepSync(), sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.column(0), 1);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('no allocations in steady state', function() {
+				var scope = {
+					filename: './stmt_step_allocations_test.db'
+				};
+
+				function stepToEnd(code) {
+					if (code === sqlite.errorCodes.SQLITE_ROW) {
+						return Q.ninvoke(scope.stmt, 'step').then(stepToEnd);
+					}
+					return code;
+				}
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function(code) {
+						scope.allocations = sqlite.allocationCount();
+						return stepToEnd(code);
+					})
+					.then(function(code) {
+						assert.strictEqual(code, sqlite.errorCodes.SQLITE_DONE);
+						assert.strictEqual(sqlite.allocationCount(), scope.allocations);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('sync', function() {
+			it('prepare, run & step', function() {
+				var scope = {
+					filename: './stmt_sync_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						var createStmt = db.prepareSync('create table test_table_0 (id integer primary key not null, col_1 integer);');
+						createStmt.runSync();
+						createStmt.finalize();
+
+						var insertStmt = db.prepareSync('insert into test_table_0 (id, col_1) values (?, ?)');
+						assert.strictEqual(insertStmt.runSync([1, 100]), sqlite.errorCodes.SQLITE_DONE);
+						assert.strictEqual(insertStmt.runSync([2, 200]), sqlite.errorCodes.SQLITE_DONE);
+						insertStmt.finalize();
+
+						scope.stmt = db.prepareSync('select col_1 from test_table_0 order by id');
+						assert.strictEqual(scope.stmt.stepSync(), sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.columnInteger(0), 100);
+						assert.strictEqual(scope.stmt.stepSync(), sqlite.errorCodes.SQLITE_ROW);
+						assert.strictEqual(scope.stmt.columnInteger(0), 200);
+						assert.strictEqual(scope.stmt.stepSync(), sqlite.errorCodes.SQLITE_DONE);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('prepare error', function() {
+				var scope = {
+					filename: './stmt_sync_prepare_error_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						assert.throws(function() {
+							db.prepareSync('select no_test_column_0 from no_test_table_1;');
+						});
+						assert.strictEqual(db.errMsg(), 'no such table: no_test_table_1');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('all', function() {
+			it('rows', function() {
+				var scope = {
+					filename: './stmt_all_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 200) select x as id, x * 0.5 as half, \'row \' || x as label, null as nothing from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 200);
+						assert.deepEqual(rows[0], {
+							id: 1,
+							half: 0.5,
+							label: 'row 1',
+							nothing: null
+						});
+						assert.deepEqual(rows[199], {
+							id: 200,
+							half: 100,
+							label: 'row 200',
+							nothing: null
+						});
+						return Q.ninvoke(scope.stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 200);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('row keys', function() {
+				var scope = {
+					filename: './stmt_all_keys_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select 1 as b, \'x\' as a, null as c union all select 2, null, 3.5');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.deepEqual(Object.keys(rows[0]), ['b', 'a', 'c']);
+						assert.deepEqual(Object.keys(rows[1]), Object.keys(rows[0]));
+						assert.deepEqual(rows[1], {
+							b: 2,
+							a: null,
+							c: 3.5
+						});
+						return Q.ninvoke(scope.stmt, 'get');
+					})
+					.then(function(row) {
+						assert.deepEqual(Object.keys(row), ['b', 'a', 'c']);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('lazy', function() {
+				var scope = {
+					filename: './stmt_all_lazy_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x as id, x * 0.5 as half, \'row \' || x as label, null as nothing from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all', { lazy: true });
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 100);
+						assert.strictEqual(rows[9].label, 'row 10');
+						assert.strictEqual(rows[9].label, 'row 10');
+						assert.deepEqual(Object.keys(rows[0]), ['id', 'half', 'label', 'nothing']);
+						assert.deepEqual(JSON.parse(JSON.stringify(rows[99])), {
+							id: 100,
+							half: 50,
+							label: 'row 100',
+							nothing: null
+						});
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('lazy rows outlive the statement', function() {
+				var scope = {
+					filename: './stmt_all_lazy_finalize_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 10) select x as id, \'row \' || x as label from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all', { lazy: true });
+					})
+					.then(function(rows) {
+						scope.rows = rows;
+						return Q.ninvoke(scope.stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows[0].label, 'row 1');
+						assert.strictEqual(scope.rows[4].label, 'row 5');
+
+						scope.stmt.finalize();
+						scope.stmt = null;
+						assert.strictEqual(scope.rows[9].id, 10);
+						assert.strictEqual(scope.rows[9].label, 'row 10');
+						assert.deepEqual(Object.keys(scope.rows[0]), ['id', 'label']);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('intern', function() {
+				var scope = {
+					filename: './stmt_all_intern_test.db'
+				};
+
+				var statuses = ['active', 'suspended', 'closed'];
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 0 union all select x + 1 from c where x < 299) select x as id, case x % 3 when 0 then \'active\' when 1 then \'suspended\' else \'closed\' end as status, \'unique \' || x as label from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all', { intern: true });
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 300);
+						rows.forEach(function(row, i) {
+							assert.strictEqual(row.status, statuses[i % 3]);
+							assert.strictEqual(row.label, 'unique ' + i);
+						});
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('intern past the table limits', function() {
+				var scope = {
+					filename: './stmt_all_intern_limits_test.db'
+				};
+
+				// 5000 distinct values overflow the 4096 entries of the intern
+				// table, and 100 byte values exceed its 64 byte length limit
+				var long = new Array(101).join('l');
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 0 union all select x + 1 from c where x < 9999) select \'v\' || (x % 5000) as short, \'' + long + '\' || (x % 3) as long from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all', { intern: true });
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 10000);
+						rows.forEach(function(row, i) {
+							assert.strictEqual(row.short, 'v' + (i % 5000));
+							assert.strictEqual(row.long, long + (i % 3));
+						});
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('large text', function() {
+				var scope = {
+					filename: './stmt_all_text_test.db'
+				};
+
+				var ascii = new Array(4097).join('a');
+				var unicode = new Array(2049).join('\u00e9');
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select \'' + ascii + '\' as ascii, \'' + unicode + '\' as unicode');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows[0].ascii, ascii);
+						assert.strictEqual(rows[0].unicode, unicode);
+						return Q.ninvoke(scope.stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows[0].ascii + rows[0].unicode, ascii + unicode);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('error', function() {
+				var scope = {
+					filename: './stmt_all_error_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('integer')(scope.db);
+					})
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'insert into test_table_0 (id, col_1) values (1, 1)');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 0);
+						return Q.ninvoke(scope.stmt, 'all');
+					})
+					.then(function() {
+						assert.fail('no error raised');
+					}, function(err) {
+						assert.strictEqual(err.code, 19);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('stream', function() {
+			it('batches', function() {
+				var scope = {
+					filename: './stmt_stream_test.db'
+				};
+
+				var readAll = function(stream) {
+					var deferred = Q.defer();
+					var ids = [];
+					stream.on('data', function(row) {
+						ids.push(row.id);
+					});
+					stream.on('error', deferred.reject);
+					stream.on('end', function() {
+						deferred.resolve(ids);
+					});
+					return deferred.promise;
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 1000) select x as id from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return readAll(stmt.stream({ batchRows: 64 }));
+					})
+					.then(function(ids) {
+						assert.strictEqual(ids.length, 1000);
+						for (var i = 0; i < ids.length; i++) {
+							assert.strictEqual(ids[i], i + 1);
+						}
+						return readAll(scope.stmt.stream({ batchBytes: 1 }));
+					})
+					.then(function(ids) {
+						assert.strictEqual(ids.length, 1000);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('lazy', function() {
+				var scope = {
+					filename: './stmt_stream_lazy_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 300) select x as id, \'row \' || x as label from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+
+						var deferred = Q.defer();
+						var rows = [];
+						var stream = stmt.stream({ batchRows: 64, lazy: true });
+						stream.on('data', function(row) {
+							rows.push(row);
+						});
+						stream.on('error', deferred.reject);
+						stream.on('end', function() {
+							deferred.resolve(rows);
+						});
+						return deferred.promise;
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 300);
+						assert.deepEqual(Object.keys(rows[0]), ['id', 'label']);
+						for (var i = 0; i < rows.length; i++) {
+							assert.strictEqual(rows[i].id, i + 1);
+						}
+						assert.strictEqual(rows[299].label, 'row 300');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('destroy', function() {
+				var scope = {
+					filename: './stmt_stream_destroy_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 1000) select x as id from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+
+						var deferred = Q.defer();
+						var stream = stmt.stream({ batchRows: 64 });
+						stream.once('data', function() {
+							stream.destroy();
+						});
+						stream.on('error', deferred.reject);
+						stream.on('close', deferred.resolve);
+						return deferred.promise;
+					})
+					.then(function() {
+						// runs once the batch in flight, if any, has been dropped
+						return Q.ninvoke(scope.stmt, 'get');
+					})
+					.then(function(row) {
+						assert.strictEqual(row.id, 1);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('get', function() {
+			it('row and pluck', function() {
+				var scope = {
+					filename: './stmt_get_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (1, \'one\'), (2, \'two\')'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1, id from test_table_0 where id = ?');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'get', [2]);
+					})
+					.then(function(row) {
+						assert.deepEqual(row, {
+							col_1: 'two',
+							id: 2
+						});
+						return Q.ninvoke(scope.stmt, 'pluck', [1]);
+					})
+					.then(function(value) {
+						assert.strictEqual(value, 'one');
+						return Q.ninvoke(scope.stmt, 'get', [3]);
+					})
+					.then(function(row) {
+						assert.strictEqual(row, undefined);
+						return Q.ninvoke(scope.stmt, 'pluck', [2], { priority: 'background' });
+					})
+					.then(function(value) {
+						assert.strictEqual(value, 'two');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('null parameters with options', function() {
+				var scope = {
+					filename: './stmt_get_null_params_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (1, \'one\'), (2, \'two\')'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1, id from test_table_0 where id = ?');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'get', [2]);
+					})
+					.then(function(row) {
+						assert.strictEqual(row.id, 2);
+						return Q.ninvoke(scope.stmt, 'get', null, { timeout: 10 });
+					})
+					.then(function(row) {
+						assert.deepEqual(row, {
+							col_1: 'two',
+							id: 2
+						});
+						return Q.ninvoke(scope.stmt, 'pluck', undefined, { priority: 'background' });
+					})
+					.then(function(value) {
+						assert.strictEqual(value, 'two');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('pipelined', function() {
+				var scope = {
+					filename: './stmt_get_pipelined_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (1, \'one\'), (2, \'two\'), (3, x\'74687265\')'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1, id from test_table_0 where id = ?');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.all([
+							Q.ninvoke(stmt, 'get', [1]),
+							Q.ninvoke(stmt, 'get', [2]),
+							Q.ninvoke(stmt, 'pluck', [new Buffer('thre')], { priority: 'background' }),
+							Q.ninvoke(stmt, 'get', ['3'])
+						]);
+					})
+					.then(function(results) {
+						assert.strictEqual(results[0].col_1, 'one');
+						assert.strictEqual(results[1].col_1, 'two');
+						assert.strictEqual(results[2], undefined);
+						assert.strictEqual(results[3].id, 3);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('packed', function() {
+			it('batches', function() {
+				var scope = {
+					filename: './stmt_packed_test.db'
+				};
+
+				var rows = [];
+				var readBatches = function() {
+					return Q.ninvoke(scope.stmt, 'fetchPacked', { batchRows: 128 }).then(function(reader) {
+						assert.ok(reader.length <= 128);
+						rows = rows.concat(reader.toArray());
+						return reader.done ? rows : readBatches();
+					});
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 300) select x * 10000000000 as id, x * 0.5 as half, \'row \' || x as label, case when x % 2 = 0 then x\'00ff\' end as payload from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return readBatches();
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows.length, 300);
+						assert.strictEqual(rows[0].id, 10000000000);
+						assert.strictEqual(rows[0].half, 0.5);
+						assert.strictEqual(rows[0].label, 'row 1');
+						assert.strictEqual(rows[0].payload, null);
+						assert.strictEqual(rows[299].id, 3000000000000);
+						assert.strictEqual(rows[299].payload.toString('hex'), '00ff');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('columns', function() {
+			it('declared types', function() {
+				var scope = {
+					filename: './stmt_columns_declared_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (-1099511627776, null)'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select id, col_1, \'x\' as label from test_table_0');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'columns');
+					})
+					.then(function(result) {
+						assert.deepEqual(result.columns.map(function(column) {
+							return column.type;
+						}), ['number', 'text', 'text']);
+						return Q.ninvoke(scope.stmt, 'step');
+					})
+					.then(function() {
+						assert.strictEqual(scope.stmt.column(0), -1099511627776);
+						assert.strictEqual(scope.stmt.column(1), null);
+						assert.strictEqual(scope.stmt.column(2), 'x');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('text in a datetime column', function() {
+				var scope = {
+					filename: './stmt_columns_datetime_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('datetime')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (1, \'2014-05-01 12:30:00\'), (2, 1398947400)'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1 from test_table_0 order by id');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'columns');
+					})
+					.then(function(result) {
+						var column = result.columns[0];
+						assert.strictEqual(column.type, 'text');
+
+						var text = new Buffer(column.data);
+						assert.strictEqual(text.toString('utf8', column.offsets[0], column.offsets[1]), '2014-05-01 12:30:00');
+						assert.strictEqual(text.toString('utf8', column.offsets[1], column.offsets[2]), '1398947400');
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('typed arrays', function() {
+				var scope = {
+					filename: './stmt_columns_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x as id, x * 0.5 as half, case when x % 3 = 0 then null else \'row \' || x end as label, null as nothing from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'columns');
+					})
+					.then(function(result) {
+						var isNull = function(column, row) {
+							return (column.nulls[row >> 3] & (1 << (row & 7))) !== 0;
+						};
+
+						assert.strictEqual(result.length, 100);
+						assert.deepEqual(result.columns.map(function(column) {
+							return column.name + ':' + column.type;
+						}), ['id:number', 'half:number', 'label:text', 'nothing:null']);
+
+						var id = result.columns[0];
+						assert.ok(id.values instanceof Float64Array);
+						assert.strictEqual(id.values.length, 100);
+						assert.strictEqual(id.values[0], 1);
+						assert.strictEqual(id.values[99], 100);
+						assert.strictEqual(result.columns[1].values[99], 50);
+
+						var label = result.columns[2];
+						assert.strictEqual(label.offsets.length, 101);
+						var text = new Buffer(label.data);
+						assert.strictEqual(text.toString('utf8', label.offsets[0], label.offsets[1]), 'row 1');
+						assert.strictEqual(text.toString('utf8', label.offsets[99], label.offsets[100]), 'row 100');
+						assert.ok(isNull(label, 2));
+						assert.strictEqual(label.offsets[2], label.offsets[3]);
+						assert.ok(!isNull(label, 3));
+
+						for (var i = 0; i < 100; i++) {
+							assert.ok(isNull(result.columns[3], i));
+							assert.ok(!isNull(id, i));
+						}
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('blobs and large integers', function() {
+				var scope = {
+					filename: './stmt_columns_blob_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select x\'0001ff\' as data, 9007199254740993 as big, 9007199254740992 as exact union all select zeroblob(2), 1, 2');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'columns');
+					})
+					.then(function(result) {
+						assert.deepEqual(result.columns.map(function(column) {
+							return column.name + ':' + column.type;
+						}), ['data:blob', 'big:number', 'exact:number']);
+
+						var data = result.columns[0];
+						assert.strictEqual(data.nulls[0], 0);
+						assert.deepEqual(Array.prototype.slice.call(data.offsets), [0, 3, 5]);
+						assert.deepEqual(Array.prototype.slice.call(data.data), [0, 1, 255, 0, 0]);
+
+						assert.strictEqual(result.columns[1].lossy, true);
+						assert.strictEqual(result.columns[2].lossy, false);
+						assert.strictEqual(result.columns[2].values[0], 9007199254740992);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('fill', function() {
+			it('typed arrays', function() {
+				var scope = {
+					filename: './stmt_fill_test.db',
+					targets: {
+						id: new Int32Array(64),
+						half: new Float64Array(64)
+					}
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 100) select x as id, case when x % 10 = 0 then null else x * 0.5 end as half, \'unused\' as label from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'fillInto', scope.targets, 100);
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows, 64);
+						assert.strictEqual(scope.targets.id[0], 1);
+						assert.strictEqual(scope.targets.id[63], 64);
+						assert.strictEqual(scope.targets.half[0], 0.5);
+						assert.ok(isNaN(scope.targets.half[9]));
+						return Q.ninvoke(scope.stmt, 'fillInto', scope.targets, 100);
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows, 36);
+						assert.strictEqual(scope.targets.id[0], 65);
+						assert.strictEqual(scope.targets.id[35], 100);
+						assert.strictEqual(scope.targets.half[35], 50);
+						return Q.ninvoke(scope.stmt, 'fillInto', scope.targets, 10);
+					})
+					.then(function(rows) {
+						assert.strictEqual(rows, 10);
+						assert.strictEqual(scope.targets.id[9], 10);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('no allocations in steady state', function() {
+				var scope = {
+					filename: './stmt_fill_allocations_test.db',
+					targets: {
+						id: new Int32Array(8),
+						half: new Float64Array(8)
+					}
+				};
+
+				function fillTimes(count) {
+					return Q.ninvoke(scope.stmt, 'fillInto', scope.targets, 8).then(function(rows) {
+						assert.strictEqual(rows, 8);
+						return count > 1 ? fillTimes(count - 1) : scope.targets.id[7];
+					});
+				}
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'with recursive c(x) as (select 1 union all select x + 1 from c where x < 1000) select x as id, x * 0.5 as half from c');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return fillTimes(1);
+					})
+					.then(function() {
+						scope.allocations = sqlite.allocationCount();
+						return fillTimes(20);
+					})
+					.then(function(lastId) {
+						assert.strictEqual(lastId, 168);
+						assert.strictEqual(sqlite.allocationCount(), scope.allocations);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+		});
+
+		describe('column', function() {
+			it('read row', function() {
+				var scope = {
+					filename: './stmt_read_row_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return Q.ninvoke(db, 'prepare', 'select -1099511627776 as big, 1.5 as half, \'text\' as label, x\'0102\' as payload, null as nothing');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function() {
+						var row = scope.stmt.readRow();
+						assert.strictEqual(row.big, -1099511627776);
+						assert.strictEqual(row.half, 1.5);
+						assert.strictEqual(row.label, 'text');
+						assert.strictEqual(row.payload.toString('hex'), '0102');
+						assert.strictEqual(row.nothing, null);
+
+						var array = scope.stmt.readRow('array');
+						assert.strictEqual(array.length, 5);
+						assert.strictEqual(array[0], -1099511627776);
+						assert.strictEqual(array[2], 'text');
+						assert.strictEqual(scope.stmt.columnInteger(0), -1099511627776);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('count', function() {
+				var scope = {
+					filename: './stmt_column_count_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (100, \'hello\')'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select id, col_1, 10, 20, 30, 40, 50, 60, 70, 80 from test_table_0');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function() {
+						var datatypeCode = scope.stmt.columnCount();
+						assert.strictEqual(datatypeCode, 10);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('type', function() {
+				var scope = {
+					filename: './stmt_column_type_test.db'
+				};
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('text')(scope.db);
+					})
+					.then(makeExecuteStatement('insert into test_table_0 (id, col_1) values (100, \'hello\')'))
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1 from test_table_0');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function() {
+						var datatypeCode = scope.stmt.columnType(0);
+						assert.strictEqual(datatypeCode, sqlite.datatypeCodes.SQLITE_TEXT);
+					})
+					.fin(makeCloseStatementAndDb(scope))
+					.fin(makeCleanup(scope))
+					.fail(makeReportError(scope));
+			});
+
+			it('blob', function() {
+				var scope = {
+					filename: './stmt_column_blob_test.db'
+				};
+
+				var payload = new Buffer([0, 1, 2, 253, 254, 255]);
+
+				return Q
+					.ninvoke(sqlite, 'open', scope.filename)
+					.then(function(db) {
+						scope.db = db;
+						return makeTable('blob')(scope.db);
+					})
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'insert into test_table_0 (id, col_1) values (?, ?)');
+					})
+					.then(function(stmt) {
+						stmt.bind(1);
+						stmt.bind(payload);
+						return Q.ninvoke(stmt, 'step').then(function() {
+							stmt.finalize();
+						});
+					})
+					.then(function() {
+						return Q.ninvoke(scope.db, 'prepare', 'select col_1 from test_table_0');
+					})
+					.then(function(stmt) {
+						scope.stmt = stmt;
+						return Q.ninvoke(stmt, 'step');
+					})
+					.then(function() {
+						assert.strictEqual(scope.stmt.columnType(0), sqlite.datatypeCodes.SQLITE_BLOB);
+						var value = scope.stmt.column(0);
+						assert.ok(Buffer.isBuffer(value));
+						assert.strictEqual(value.toString('hex'), payload.toString('hex'));
+						scope.stmt.reset();
+						return Q.ninvoke(scope.stmt, 'all');
+					})
+					.then(function(rows) {
+						assert.ok(Buffer.isBuffer(rows[0].col_1));
+						assert.strictEqual(rows[0].col_1.toString('hex'), payload.toString('hex'));
 					})
 					.fin(makeCloseStatementAndDb(scope))
 					.fin(makeCleanup(scope))